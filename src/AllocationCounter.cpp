@@ -0,0 +1,86 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "AllocationCounter.hpp"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+#ifdef COUNT_ALLOCATIONS
+
+static std::atomic<size_t> allocatedBytes(0);
+static std::atomic<size_t> allocationCount(0);
+
+void* operator new(size_t size)
+{
+    allocatedBytes += size;
+    allocationCount++;
+
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+bool AllocationCounter::enabled()
+{
+    return true;
+}
+
+size_t AllocationCounter::allocations()
+{
+    return allocationCount;
+}
+
+size_t AllocationCounter::bytes()
+{
+    return allocatedBytes;
+}
+
+#else
+
+bool AllocationCounter::enabled()
+{
+    return false;
+}
+
+size_t AllocationCounter::allocations()
+{
+    return 0;
+}
+
+size_t AllocationCounter::bytes()
+{
+    return 0;
+}
+
+#endif
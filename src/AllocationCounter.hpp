@@ -0,0 +1,25 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Heap allocations of the process, counted on demand
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Built with COUNT_ALLOCATIONS, the global operator new is replaced
+ * by one counting every allocation, of any thread; both counts stay 0
+ * otherwise. Only the binaries profiling their allocations link it,
+ * the tools sweeping for production keep the default one.
+*/
+class AllocationCounter
+{
+    public:
+        static bool enabled();
+
+        // since the start of the process
+        static size_t allocations();
+        static size_t bytes();
+};
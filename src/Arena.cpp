@@ -0,0 +1,75 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "Arena.hpp"
+
+#include <stdint.h>
+
+// any scalar or glm vector
+static const size_t maxAlignment = alignof(max_align_t);
+
+Arena::Arena(const size_t bytes)
+{
+    if (bytes)
+    {
+        this->block = new char[bytes];
+        this->size = bytes;
+    }
+}
+
+Arena::~Arena()
+{
+    for (char *memory: this->overflow)
+        delete[] memory;
+    delete[] this->block;
+}
+
+void* Arena::allocate(const size_t bytes, const size_t alignment)
+{
+    uintptr_t base = (uintptr_t) this->block;
+    size_t start = ((base + this->offset + alignment - 1) &
+                    ~(uintptr_t) (alignment - 1)) - base;
+
+    if (this->block && start + bytes <= this->size)
+    {
+        this->offset = start + bytes;
+        return this->block + start;
+    }
+
+    // new[] is aligned for any scalar type
+    char *memory = new char[bytes ? bytes : 1];
+    this->overflow.push_back(memory);
+    this->overflowBytes += bytes + maxAlignment;
+    return memory;
+}
+
+void Arena::reset()
+{
+    if (!this->overflow.empty())
+    {
+        size_t bytes = this->offset + this->overflowBytes;
+
+        for (char *memory: this->overflow)
+            delete[] memory;
+        this->overflow.clear();
+        this->overflowBytes = 0;
+
+        // everything since the previous reset fits from now on
+        delete[] this->block;
+        this->block = new char[bytes];
+        this->size = bytes;
+    }
+    this->offset = 0;
+}
+
+size_t Arena::capacity() const
+{
+    return this->size;
+}
+
+size_t Arena::used() const
+{
+    return this->offset + this->overflowBytes;
+}
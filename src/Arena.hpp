@@ -0,0 +1,58 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Bump allocator for the scratch memory of a regeneration
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+/*
+ * Hands out uninitialized storage, released all at once by reset():
+ * whatever did not fit in the block since the previous reset got its
+ * own, and reset() merges them into a single block large enough for
+ * all of it, so the same work allocates nothing the next time.
+ * Not thread safe, allocate from the thread that resets it.
+*/
+class Arena
+{
+    public:
+        Arena(const size_t bytes = 0);
+        ~Arena();
+
+        // trivially destructible types only, never freed one by one
+        template <typename T>
+        T* allocate(const size_t count)
+        {
+            return (T*) this->allocate(sizeof(T) * count, alignof(T));
+        }
+        void* allocate(const size_t bytes, const size_t alignment);
+
+        // from the arena if any, else from fallback, resized to count
+        template <typename T>
+        static T* scratch(Arena *arena, const size_t count,
+                          std::vector<T> &fallback)
+        {
+            if (arena)
+                return arena->allocate<T>(count);
+            fallback.resize(count);
+            return fallback.empty() ? NULL : &fallback[0];
+        }
+
+        void reset();
+
+        // of the block, and taken from it or any other since reset()
+        size_t capacity() const;
+        size_t used() const;
+
+    private:
+        char *block = NULL;
+        size_t size = 0;
+        size_t offset = 0;
+        // what did not fit in the block, until reset()
+        std::vector<char*> overflow;
+        size_t overflowBytes = 0;
+};
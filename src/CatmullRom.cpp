@@ -0,0 +1,598 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "CatmullRom.hpp"
+
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CATMULL_ROM_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Kernels: segments are evaluated in SoA form, one lane per segment,
+ * sample j of segment i being w0 p_i-1 + w1 p_i + w2 p_i+1 + w3 p_i+2.
+*/
+
+static inline void evaluateSegments(const float *x,
+                                    const float *y,
+                                    const float *z,
+                                    const size_t first,
+                                    const size_t last,
+                                    const float *weights,
+                                    const size_t segmentSamples,
+                                    glm::vec3 *samples)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        glm::vec3 *out = samples + i * segmentSamples;
+
+        for (size_t j = 0; j < segmentSamples; j++)
+        {
+            const float *w = weights + 4 * j;
+
+            out[j] = glm::vec3(
+                w[0] * x[i] + w[1] * x[i + 1] + w[2] * x[i + 2] + w[3] * x[i + 3],
+                w[0] * y[i] + w[1] * y[i + 1] + w[2] * y[i + 2] + w[3] * y[i + 3],
+                w[0] * z[i] + w[1] * z[i + 1] + w[2] * z[i + 2] + w[3] * z[i + 3]
+            );
+        }
+    }
+}
+
+static void evaluateScalar(const float *x, const float *y, const float *z,
+                           const size_t segments, const float *weights,
+                           const size_t segmentSamples, glm::vec3 *samples)
+{
+    evaluateSegments(x, y, z, 0, segments,
+                     weights, segmentSamples, samples);
+}
+
+#if defined(CATMULL_ROM_X86)
+
+static void evaluateSSE(const float *x, const float *y, const float *z,
+                        const size_t segments, const float *weights,
+                        const size_t segmentSamples, glm::vec3 *samples)
+{
+    size_t i = 0;
+    float ox[4], oy[4], oz[4];
+
+    for (; i + 4 <= segments; i += 4)
+    {
+        __m128 x0 = _mm_loadu_ps(x + i), x1 = _mm_loadu_ps(x + i + 1),
+               x2 = _mm_loadu_ps(x + i + 2), x3 = _mm_loadu_ps(x + i + 3);
+        __m128 y0 = _mm_loadu_ps(y + i), y1 = _mm_loadu_ps(y + i + 1),
+               y2 = _mm_loadu_ps(y + i + 2), y3 = _mm_loadu_ps(y + i + 3);
+        __m128 z0 = _mm_loadu_ps(z + i), z1 = _mm_loadu_ps(z + i + 1),
+               z2 = _mm_loadu_ps(z + i + 2), z3 = _mm_loadu_ps(z + i + 3);
+
+        for (size_t j = 0; j < segmentSamples; j++)
+        {
+            const float *w = weights + 4 * j;
+            __m128 w0 = _mm_set1_ps(w[0]), w1 = _mm_set1_ps(w[1]),
+                   w2 = _mm_set1_ps(w[2]), w3 = _mm_set1_ps(w[3]);
+
+            _mm_storeu_ps(ox, _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(w0, x0), _mm_mul_ps(w1, x1)),
+                _mm_mul_ps(w2, x2)), _mm_mul_ps(w3, x3)));
+            _mm_storeu_ps(oy, _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(w0, y0), _mm_mul_ps(w1, y1)),
+                _mm_mul_ps(w2, y2)), _mm_mul_ps(w3, y3)));
+            _mm_storeu_ps(oz, _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(w0, z0), _mm_mul_ps(w1, z1)),
+                _mm_mul_ps(w2, z2)), _mm_mul_ps(w3, z3)));
+
+            for (size_t l = 0; l < 4; l++)
+                samples[(i + l) * segmentSamples + j] =
+                    glm::vec3(ox[l], oy[l], oz[l]);
+        }
+    }
+    evaluateSegments(x, y, z, i, segments,
+                     weights, segmentSamples, samples);
+}
+
+__attribute__((target("avx2,fma")))
+static void evaluateAVX2(const float *x, const float *y, const float *z,
+                         const size_t segments, const float *weights,
+                         const size_t segmentSamples, glm::vec3 *samples)
+{
+    size_t i = 0;
+    float ox[8], oy[8], oz[8];
+
+    for (; i + 8 <= segments; i += 8)
+    {
+        __m256 x0 = _mm256_loadu_ps(x + i), x1 = _mm256_loadu_ps(x + i + 1),
+               x2 = _mm256_loadu_ps(x + i + 2), x3 = _mm256_loadu_ps(x + i + 3);
+        __m256 y0 = _mm256_loadu_ps(y + i), y1 = _mm256_loadu_ps(y + i + 1),
+               y2 = _mm256_loadu_ps(y + i + 2), y3 = _mm256_loadu_ps(y + i + 3);
+        __m256 z0 = _mm256_loadu_ps(z + i), z1 = _mm256_loadu_ps(z + i + 1),
+               z2 = _mm256_loadu_ps(z + i + 2), z3 = _mm256_loadu_ps(z + i + 3);
+
+        for (size_t j = 0; j < segmentSamples; j++)
+        {
+            const float *w = weights + 4 * j;
+            __m256 w0 = _mm256_set1_ps(w[0]), w1 = _mm256_set1_ps(w[1]),
+                   w2 = _mm256_set1_ps(w[2]), w3 = _mm256_set1_ps(w[3]);
+
+            _mm256_storeu_ps(ox, _mm256_fmadd_ps(w3, x3, _mm256_fmadd_ps(
+                w2, x2, _mm256_fmadd_ps(w1, x1, _mm256_mul_ps(w0, x0)))));
+            _mm256_storeu_ps(oy, _mm256_fmadd_ps(w3, y3, _mm256_fmadd_ps(
+                w2, y2, _mm256_fmadd_ps(w1, y1, _mm256_mul_ps(w0, y0)))));
+            _mm256_storeu_ps(oz, _mm256_fmadd_ps(w3, z3, _mm256_fmadd_ps(
+                w2, z2, _mm256_fmadd_ps(w1, z1, _mm256_mul_ps(w0, z0)))));
+
+            for (size_t l = 0; l < 8; l++)
+                samples[(i + l) * segmentSamples + j] =
+                    glm::vec3(ox[l], oy[l], oz[l]);
+        }
+    }
+    evaluateSegments(x, y, z, i, segments,
+                     weights, segmentSamples, samples);
+}
+
+#elif defined(__ARM_NEON)
+
+static void evaluateNEON(const float *x, const float *y, const float *z,
+                         const size_t segments, const float *weights,
+                         const size_t segmentSamples, glm::vec3 *samples)
+{
+    size_t i = 0;
+    float ox[4], oy[4], oz[4];
+
+    for (; i + 4 <= segments; i += 4)
+    {
+        float32x4_t x0 = vld1q_f32(x + i), x1 = vld1q_f32(x + i + 1),
+                    x2 = vld1q_f32(x + i + 2), x3 = vld1q_f32(x + i + 3);
+        float32x4_t y0 = vld1q_f32(y + i), y1 = vld1q_f32(y + i + 1),
+                    y2 = vld1q_f32(y + i + 2), y3 = vld1q_f32(y + i + 3);
+        float32x4_t z0 = vld1q_f32(z + i), z1 = vld1q_f32(z + i + 1),
+                    z2 = vld1q_f32(z + i + 2), z3 = vld1q_f32(z + i + 3);
+
+        for (size_t j = 0; j < segmentSamples; j++)
+        {
+            const float *w = weights + 4 * j;
+
+            vst1q_f32(ox, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(
+                vmulq_n_f32(x0, w[0]), x1, w[1]), x2, w[2]), x3, w[3]));
+            vst1q_f32(oy, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(
+                vmulq_n_f32(y0, w[0]), y1, w[1]), y2, w[2]), y3, w[3]));
+            vst1q_f32(oz, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(
+                vmulq_n_f32(z0, w[0]), z1, w[1]), z2, w[2]), z3, w[3]));
+
+            for (size_t l = 0; l < 4; l++)
+                samples[(i + l) * segmentSamples + j] =
+                    glm::vec3(ox[l], oy[l], oz[l]);
+        }
+    }
+    evaluateSegments(x, y, z, i, segments,
+                     weights, segmentSamples, samples);
+}
+
+#endif
+
+CatmullRom::CatmullRom(const float tension, const float tmax) :
+    tension(tension),
+    tmax(tmax)
+{
+    float s = this->tension;
+
+    glm::mat4 basis(
+        -s,     2-s,    s-2,    s,      // [0][0]-[0][3]
+        2*s,    s-3,    3-2*s,  -s,
+        -s,     0,      s,      0,
+        0,      1,      0,      0
+    );
+
+    float step = 1.0f / this->tmax;
+
+    // same t sequence as the brute force loop it replaces
+    for (float t = 0.0f; t < 1.0f - step; t += step)
+    {
+        glm::vec4 params = glm::vec4(t*t*t, t*t, t, 1.0f);
+
+        // row vector: w_k = sum over m of params_m * basis[m][k]
+        glm::vec4 w = params * glm::transpose(basis);
+
+        this->weights.push_back(w[0]);
+        this->weights.push_back(w[1]);
+        this->weights.push_back(w[2]);
+        this->weights.push_back(w[3]);
+
+        // d/dt of the params, same basis
+        glm::vec4 dw = glm::vec4(3*t*t, 2*t, 1.0f, 0.0f) *
+                       glm::transpose(basis);
+
+        this->tangentWeights.push_back(dw[0]);
+        this->tangentWeights.push_back(dw[1]);
+        this->tangentWeights.push_back(dw[2]);
+        this->tangentWeights.push_back(dw[3]);
+    }
+
+    this->setKernel(CatmullRom::bestKernel());
+}
+
+CatmullRom::~CatmullRom()
+{
+}
+
+float CatmullRom::getTension() const
+{
+    return this->tension;
+}
+
+float CatmullRom::getTmax() const
+{
+    return this->tmax;
+}
+
+size_t CatmullRom::getSegmentSamples() const
+{
+    return this->weights.size() / 4;
+}
+
+CatmullRom::Kernel CatmullRom::bestKernel()
+{
+    if (CatmullRom::kernelSupported(CatmullRom::Kernel::AVX2))
+        return CatmullRom::Kernel::AVX2;
+    if (CatmullRom::kernelSupported(CatmullRom::Kernel::SSE))
+        return CatmullRom::Kernel::SSE;
+    if (CatmullRom::kernelSupported(CatmullRom::Kernel::NEON))
+        return CatmullRom::Kernel::NEON;
+    return CatmullRom::Kernel::Scalar;
+}
+
+bool CatmullRom::kernelSupported(const CatmullRom::Kernel kernel)
+{
+    switch (kernel)
+    {
+        case CatmullRom::Kernel::Scalar:
+            return true;
+#if defined(CATMULL_ROM_X86)
+        case CatmullRom::Kernel::SSE:
+            return __builtin_cpu_supports("sse2");
+        case CatmullRom::Kernel::AVX2:
+            return __builtin_cpu_supports("avx2") &&
+                   __builtin_cpu_supports("fma");
+#elif defined(__ARM_NEON)
+        case CatmullRom::Kernel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* CatmullRom::kernelName(const CatmullRom::Kernel kernel)
+{
+    switch (kernel)
+    {
+        case CatmullRom::Kernel::Scalar:
+            return "scalar";
+        case CatmullRom::Kernel::SSE:
+            return "sse";
+        case CatmullRom::Kernel::AVX2:
+            return "avx2";
+        case CatmullRom::Kernel::NEON:
+            return "neon";
+    }
+    return "";
+}
+
+CatmullRom::Kernel CatmullRom::getKernel() const
+{
+    return this->kernel;
+}
+
+bool CatmullRom::setKernel(const CatmullRom::Kernel kernel)
+{
+    if (!CatmullRom::kernelSupported(kernel))
+        return false;
+
+    this->kernel = kernel;
+
+    switch (kernel)
+    {
+#if defined(CATMULL_ROM_X86)
+        case CatmullRom::Kernel::SSE:
+            this->kernelFunction = evaluateSSE;
+            break;
+        case CatmullRom::Kernel::AVX2:
+            this->kernelFunction = evaluateAVX2;
+            break;
+#elif defined(__ARM_NEON)
+        case CatmullRom::Kernel::NEON:
+            this->kernelFunction = evaluateNEON;
+            break;
+#endif
+        default:
+            this->kernelFunction = evaluateScalar;
+            break;
+    }
+    return true;
+}
+
+Arena* CatmullRom::getArena() const
+{
+    return this->arena;
+}
+
+void CatmullRom::setArena(Arena *arena)
+{
+    this->arena = arena;
+}
+
+CatmullRom::Subdivision CatmullRom::getSubdivision() const
+{
+    return this->subdivision;
+}
+
+void CatmullRom::setUniform()
+{
+    this->subdivision = CatmullRom::Subdivision::Uniform;
+}
+
+bool CatmullRom::setAdaptive(const float chordalTolerance,
+                             const float angularTolerance)
+{
+    if (chordalTolerance <= 0 && angularTolerance <= 0)
+        return false;
+
+    this->subdivision = CatmullRom::Subdivision::Adaptive;
+    this->chordalTolerance = chordalTolerance;
+    this->angularTolerance = angularTolerance;
+    return true;
+}
+
+size_t CatmullRom::uniformSamples(const size_t controlPoints) const
+{
+    if (controlPoints < 4)
+        return 0;
+    return (controlPoints - 3) * this->getSegmentSamples();
+}
+
+glm::vec3 CatmullRom::point(const glm::vec3 *p, const float t) const
+{
+    float s = this->tension;
+    float t2 = t * t;
+    float t3 = t2 * t;
+
+    // closed form of the basis rows
+    return s * (-t3 + 2 * t2 - t) * p[0] +
+           ((2 - s) * t3 + (s - 3) * t2 + 1) * p[1] +
+           ((s - 2) * t3 + (3 - 2 * s) * t2 + s * t) * p[2] +
+           s * (t3 - t2) * p[3];
+}
+
+glm::vec3 CatmullRom::tangent(const glm::vec3 *p, const float t) const
+{
+    float s = this->tension;
+    float t2 = t * t;
+
+    // d/dt of point()
+    return s * (-3 * t2 + 4 * t - 1) * p[0] +
+           (3 * (2 - s) * t2 + 2 * (s - 3) * t) * p[1] +
+           (3 * (s - 2) * t2 + 2 * (3 - 2 * s) * t + s) * p[2] +
+           s * (3 * t2 - 2 * t) * p[3];
+}
+
+bool CatmullRom::flat(const glm::vec3 &a, const glm::vec3 &m,
+                      const glm::vec3 &b) const
+{
+    glm::vec3 chord = b - a;
+    float chordLength = glm::length(chord);
+
+    if (this->chordalTolerance > 0)
+    {
+        // distance of m to the chord line
+        float error = (chordLength > 0) ?
+            glm::length(glm::cross(m - a, chord)) / chordLength :
+            glm::length(m - a);
+
+        if (error > this->chordalTolerance)
+            return false;
+    }
+    if (this->angularTolerance > 0)
+    {
+        glm::vec3 u = m - a;
+        glm::vec3 v = b - m;
+        float uv = glm::length(u) * glm::length(v);
+
+        if (uv > 0)
+        {
+            float cosine = glm::dot(u, v) / uv;
+            if (cosine < cosf(this->angularTolerance))
+                return false;
+        }
+    }
+    return true;
+}
+
+void CatmullRom::subdivide(const glm::vec3 *p,
+                           const float ta, const glm::vec3 &a,
+                           const float tb, const glm::vec3 &b,
+                           const unsigned int depth,
+                           std::vector<glm::vec3> &samples,
+                           std::vector<glm::vec3> *tangents) const
+{
+    // 2^10 samples per segment at most
+    const unsigned int maxDepth = 10;
+
+    float tm = 0.5f * (ta + tb);
+    glm::vec3 m = this->point(p, tm);
+
+    bool split = !this->flat(a, m, b);
+
+    // a chord can cut an S-shaped segment right through its middle
+    if (!split && depth == 0)
+        split = !this->flat(a, this->point(p, 0.5f * (ta + tm)), m) ||
+                !this->flat(m, this->point(p, 0.5f * (tm + tb)), b);
+
+    if (!split || depth == maxDepth)
+        return;
+
+    this->subdivide(p, ta, a, tm, m, depth + 1, samples, tangents);
+    samples.push_back(m);
+    if (tangents)
+        tangents->push_back(this->tangent(p, tm));
+    this->subdivide(p, tm, m, tb, b, depth + 1, samples, tangents);
+}
+
+void CatmullRom::evaluateAdaptive(const glm::vec3 *controlPoints,
+                                  const size_t points,
+                                  std::vector<glm::vec3> &samples,
+                                  std::vector<glm::vec3> *tangents) const
+{
+    samples.clear();
+    if (tangents)
+        tangents->clear();
+
+    glm::vec3 a = this->point(&controlPoints[0], 0.0f);
+
+    // segment i joins p_i and p_i+1
+    for (size_t i = 0; i + 3 < points; i++)
+    {
+        const glm::vec3 *p = &controlPoints[i];
+        glm::vec3 b = this->point(p, 1.0f);
+
+        samples.push_back(a);
+        if (tangents)
+            tangents->push_back(this->tangent(p, 0.0f));
+        this->subdivide(p, 0.0f, a, 1.0f, b, 0, samples, tangents);
+        a = b;
+    }
+    samples.push_back(a);
+    if (tangents)
+        tangents->push_back(this->tangent(&controlPoints[points - 4], 1.0f));
+}
+
+bool CatmullRom::evaluate(const std::vector<glm::vec3> &controlPoints,
+                          std::vector<glm::vec3> &samples) const
+{
+    if (controlPoints.empty())
+        return false;
+    return this->evaluate(&controlPoints[0], controlPoints.size(), samples);
+}
+
+bool CatmullRom::evaluate(const glm::vec3 *controlPoints,
+                          const size_t points,
+                          std::vector<glm::vec3> &samples) const
+{
+    if (points < 4)
+        return false;
+
+    if (this->subdivision == CatmullRom::Subdivision::Adaptive)
+    {
+        this->evaluateAdaptive(controlPoints, points, samples, NULL);
+        return true;
+    }
+
+    // for n segments with n+3 control points
+    size_t segments = points - 3;
+
+    samples.resize(segments * this->getSegmentSamples());
+
+    if (samples.empty())
+        return true;
+
+    // AoS -> SoA
+    std::vector<float> soa;
+    float *x = Arena::scratch(this->arena, 3 * points, soa);
+    float *y = x + points;
+    float *z = y + points;
+
+    for (size_t i = 0; i < points; i++)
+    {
+        x[i] = controlPoints[i].x;
+        y[i] = controlPoints[i].y;
+        z[i] = controlPoints[i].z;
+    }
+
+    this->kernelFunction(x, y, z, segments, &this->weights[0],
+                         this->getSegmentSamples(), &samples[0]);
+    return true;
+}
+
+bool CatmullRom::evaluate(const glm::vec3 *controlPoints,
+                          const size_t points,
+                          std::vector<glm::vec3> &samples,
+                          std::vector<glm::vec3> &tangents) const
+{
+    if (points < 4)
+        return false;
+
+    if (this->subdivision == CatmullRom::Subdivision::Adaptive)
+    {
+        this->evaluateAdaptive(controlPoints, points, samples, &tangents);
+        return true;
+    }
+
+    size_t segments = points - 3;
+
+    samples.resize(segments * this->getSegmentSamples());
+    tangents.resize(samples.size());
+
+    if (samples.empty())
+        return true;
+
+    // AoS -> SoA, once for both
+    std::vector<float> soa;
+    float *x = Arena::scratch(this->arena, 3 * points, soa);
+    float *y = x + points;
+    float *z = y + points;
+
+    for (size_t i = 0; i < points; i++)
+    {
+        x[i] = controlPoints[i].x;
+        y[i] = controlPoints[i].y;
+        z[i] = controlPoints[i].z;
+    }
+
+    this->kernelFunction(x, y, z, segments, &this->weights[0],
+                         this->getSegmentSamples(), &samples[0]);
+    this->kernelFunction(x, y, z, segments, &this->tangentWeights[0],
+                         this->getSegmentSamples(), &tangents[0]);
+    return true;
+}
+
+bool CatmullRom::evaluateSegments(const glm::vec3 *controlPoints,
+                                  const size_t points,
+                                  const size_t first, const size_t last,
+                                  glm::vec3 *samples) const
+{
+    if (this->subdivision == CatmullRom::Subdivision::Adaptive ||
+        points < 4 || first > last || last > points - 3)
+    {
+        return false;
+    }
+
+    if (first == last)
+        return true;
+
+    // AoS -> SoA, the control points of these segments only, on the
+    // stack for the few segments of an edit or a stream
+    size_t count = last - first + 3;
+    float local[3 * 16];
+    std::vector<float> soa;
+    if (count > 16)
+        soa.resize(3 * count);
+    float *x = soa.empty() ? local : &soa[0];
+    float *y = x + count;
+    float *z = y + count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        x[i] = controlPoints[first + i].x;
+        y[i] = controlPoints[first + i].y;
+        z[i] = controlPoints[first + i].z;
+    }
+
+    this->kernelFunction(x, y, z, last - first, &this->weights[0],
+                         this->getSegmentSamples(),
+                         samples + first * this->getSegmentSamples());
+    return true;
+}
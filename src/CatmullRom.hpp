@@ -0,0 +1,125 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Catmull-Rom evaluation over plain control points (no OpenGL)
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Arena.hpp"
+
+class CatmullRom
+{
+    public:
+        enum Kernel {
+            Scalar = 0,
+            SSE = 1,
+            AVX2 = 2,
+            NEON = 3
+        };
+
+        enum Subdivision {
+            Uniform = 0,
+            Adaptive = 1
+        };
+
+        CatmullRom(const float tension = 0.5f,
+                   const float tmax = 10.0f);
+        ~CatmullRom();
+
+        float getTension() const;
+        float getTmax() const;
+        size_t getSegmentSamples() const;
+
+        // fastest kernel supported by the running cpu
+        static Kernel bestKernel();
+        static bool kernelSupported(const Kernel kernel);
+        static const char* kernelName(const Kernel kernel);
+
+        Kernel getKernel() const;
+        bool setKernel(const Kernel kernel);
+
+        // not owned, the SoA copies of evaluate() from it, NULL: the heap
+        Arena* getArena() const;
+        void setArena(Arena *arena);
+
+        Subdivision getSubdivision() const;
+        void setUniform();
+        /*
+         * Splits a segment until its samples are within chordalTolerance
+         * of the chords and turn by less than angularTolerance (radians)
+         * from one chord to the next; a tolerance <= 0 is ignored.
+        */
+        bool setAdaptive(const float chordalTolerance,
+                         const float angularTolerance);
+
+        // samples a uniform evaluation emits for as many control points
+        size_t uniformSamples(const size_t controlPoints) const;
+
+        // samples n segments out of n + 3 control points
+        bool evaluate(const std::vector<glm::vec3> &controlPoints,
+                      std::vector<glm::vec3> &samples) const;
+        bool evaluate(const glm::vec3 *controlPoints, const size_t points,
+                      std::vector<glm::vec3> &samples) const;
+        /*
+         * With the derivative at every sample too, of the same basis
+         * differentiated in t and run through the same kernel; only
+         * their directions are meaningful.
+        */
+        bool evaluate(const glm::vec3 *controlPoints, const size_t points,
+                      std::vector<glm::vec3> &samples,
+                      std::vector<glm::vec3> &tangents) const;
+        /*
+         * Segments [first, last) of a uniform evaluation only, written
+         * in place from samples + first * getSegmentSamples(); false
+         * with adaptive subdivision.
+        */
+        bool evaluateSegments(const glm::vec3 *controlPoints,
+                              const size_t points,
+                              const size_t first, const size_t last,
+                              glm::vec3 *samples) const;
+
+    private:
+        glm::vec3 point(const glm::vec3 *p, const float t) const;
+        glm::vec3 tangent(const glm::vec3 *p, const float t) const;
+        bool flat(const glm::vec3 &a, const glm::vec3 &m,
+                  const glm::vec3 &b) const;
+        void subdivide(const glm::vec3 *p,
+                       const float ta, const glm::vec3 &a,
+                       const float tb, const glm::vec3 &b,
+                       const unsigned int depth,
+                       std::vector<glm::vec3> &samples,
+                       std::vector<glm::vec3> *tangents) const;
+        // tangents of the samples too unless NULL
+        void evaluateAdaptive(const glm::vec3 *controlPoints,
+                              const size_t points,
+                              std::vector<glm::vec3> &samples,
+                              std::vector<glm::vec3> *tangents) const;
+
+        typedef void (*KernelFunction)(const float *x,
+                                       const float *y,
+                                       const float *z,
+                                       const size_t segments,
+                                       const float *weights,
+                                       const size_t segmentSamples,
+                                       glm::vec3 *samples);
+
+        float tension;
+        float tmax;
+        // basis weights of the 4 control points for every t of a segment
+        std::vector<float> weights;
+        // and of their derivatives
+        std::vector<float> tangentWeights;
+        Kernel kernel;
+        KernelFunction kernelFunction;
+        Subdivision subdivision = Subdivision::Uniform;
+        Arena *arena = NULL;
+        float chordalTolerance = 0;
+        float angularTolerance = 0;
+};
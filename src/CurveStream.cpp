@@ -0,0 +1,106 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "CurveStream.hpp"
+
+#include <algorithm>
+
+CurveStream::CurveStream(const CatmullRom &curve, const size_t capacity) :
+    curve(curve),
+    capacity(std::max(capacity, (size_t) 1)),
+    ring(this->capacity + 1),
+    segment(curve.getSegmentSamples())
+{
+    // a single segment at a time, whatever the subdivision
+    this->curve.setUniform();
+    // appended to from any thread, evaluated on the stack anyway
+    this->curve.setArena(NULL);
+}
+
+CurveStream::~CurveStream()
+{
+}
+
+size_t CurveStream::getCapacity() const
+{
+    return this->capacity;
+}
+
+const CatmullRom& CurveStream::getCurve() const
+{
+    return this->curve;
+}
+
+void CurveStream::append(const glm::vec3 &controlPoint)
+{
+    if (this->points == 4)
+    {
+        std::copy(this->window + 1, this->window + 4, this->window);
+        this->points = 3;
+    }
+    this->window[this->points++] = controlPoint;
+
+    if (this->points < 4 || this->segment.empty())
+        return;
+
+    this->curve.evaluateSegments(this->window, 4, 0, 1, &this->segment[0]);
+
+    for (const auto &sample: this->segment)
+    {
+        this->ring[this->next] = sample;
+        if (this->next == 0)
+            this->ring[this->capacity] = sample;
+
+        this->next = (this->next + 1) % this->capacity;
+        this->total++;
+    }
+}
+
+void CurveStream::clear()
+{
+    this->points = 0;
+    this->next = 0;
+    this->total = 0;
+}
+
+size_t CurveStream::size() const
+{
+    return (size_t) std::min(this->total, (uint64_t) this->capacity);
+}
+
+uint64_t CurveStream::written() const
+{
+    return this->total;
+}
+
+size_t CurveStream::head() const
+{
+    return this->next;
+}
+
+const glm::vec3* CurveStream::data() const
+{
+    return &this->ring[0];
+}
+
+size_t CurveStream::ranges(size_t first[2], size_t count[2]) const
+{
+    if (this->total == 0)
+        return 0;
+
+    // not wrapped yet, or wrapped right at the end
+    if (this->total <= this->capacity || this->next == 0)
+    {
+        first[0] = 0;
+        count[0] = this->size();
+        return 1;
+    }
+
+    first[0] = this->next;
+    count[0] = this->capacity + 1 - this->next;
+    first[1] = 0;
+    count[1] = this->next;
+    return 2;
+}
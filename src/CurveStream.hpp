@@ -0,0 +1,62 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Unbounded stream of control points sampled into a bounded ring
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "CatmullRom.hpp"
+
+/*
+ * Keeps the last 4 control points and the last capacity samples only:
+ * each appended point evaluates the one segment it completes, O(1) in
+ * time and memory however long the stream runs. Sampled uniformly.
+ *
+ * The ring holds capacity + 1 samples, the last slot repeating the
+ * first one, so that from the oldest to the newest the samples are at
+ * most two ranges a line strip joins: [head, capacity + 1) and [0, head).
+*/
+class CurveStream
+{
+    public:
+        CurveStream(const CatmullRom &curve, const size_t capacity);
+        ~CurveStream();
+
+        size_t getCapacity() const;
+        const CatmullRom& getCurve() const;
+
+        void append(const glm::vec3 &controlPoint);
+        // forgets every point and sample
+        void clear();
+
+        // samples in the ring
+        size_t size() const;
+        // samples appended since the start, overwritten ones included
+        uint64_t written() const;
+        // next slot to be written
+        size_t head() const;
+
+        const glm::vec3* data() const;
+        // oldest to newest, returns the number of ranges (0 to 2)
+        size_t ranges(size_t first[2], size_t count[2]) const;
+
+    private:
+        CatmullRom curve;
+        size_t capacity;
+        std::vector<glm::vec3> ring;
+        // control points of the next segment, the oldest first
+        glm::vec3 window[4];
+        size_t points = 0;
+        // samples of one segment, evaluated before entering the ring
+        std::vector<glm::vec3> segment;
+        size_t next = 0;
+        uint64_t total = 0;
+};
@@ -4,6 +4,183 @@
 */
 
 #include "DataModel.hpp"
+#include "ModelFile.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+
+/*
+ * Text models are parsed line by line from a single read of the
+ * file: one count or one "x y z" vertex per line, blank lines and
+ * carriage returns skipped.
+*/
+struct TextCursor
+{
+    const char *p;
+    const char *end;
+    size_t line;
+};
+
+static bool readFile(const std::string &filename, std::string &text)
+{
+    struct stat st;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    text.resize(st.st_size);
+
+    size_t done = 0;
+    while (done < text.size())
+    {
+        ssize_t n = read(fd, &text[done], text.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += n;
+    }
+    close(fd);
+    text.resize(done);
+    return true;
+}
+
+static void skipBlanks(TextCursor &cursor)
+{
+    while (cursor.p < cursor.end &&
+           (*cursor.p == ' ' || *cursor.p == '\t' || *cursor.p == '\r'))
+    {
+        cursor.p++;
+    }
+}
+
+static void skipEmptyLines(TextCursor &cursor)
+{
+    skipBlanks(cursor);
+
+    while (cursor.p < cursor.end && *cursor.p == '\n')
+    {
+        cursor.p++;
+        cursor.line++;
+        skipBlanks(cursor);
+    }
+}
+
+// nothing else but blanks up to the end of the line
+static bool endLine(TextCursor &cursor)
+{
+    skipBlanks(cursor);
+
+    if (cursor.p == cursor.end)
+        return true;
+    if (*cursor.p != '\n')
+        return false;
+
+    cursor.p++;
+    cursor.line++;
+    return true;
+}
+
+static bool parseCount(TextCursor &cursor, uint32_t &count)
+{
+    skipEmptyLines(cursor);
+
+    auto result = std::from_chars(cursor.p, cursor.end, count);
+    if (result.ec != std::errc())
+        return false;
+
+    cursor.p = result.ptr;
+    return endLine(cursor);
+}
+
+static bool parseVertices(TextCursor &cursor, const uint32_t count,
+                          std::vector<glm::vec3> &vertices)
+{
+    // "0 0 0\n" is the shortest vertex, don't trust larger counts
+    size_t left = cursor.end - cursor.p;
+    vertices.reserve(std::min<size_t>(count, left / 6 + 1));
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 v;
+
+        skipEmptyLines(cursor);
+
+        for (int c = 0; c < 3; c++)
+        {
+            skipBlanks(cursor);
+
+            auto result = std::from_chars(cursor.p, cursor.end, v[c]);
+            if (result.ec != std::errc())
+                return false;
+            cursor.p = result.ptr;
+
+            // separated by blanks
+            if (c < 2 && cursor.p < cursor.end &&
+                *cursor.p != ' ' && *cursor.p != '\t')
+            {
+                return false;
+            }
+        }
+        if (!endLine(cursor))
+            return false;
+
+        vertices.push_back(v);
+    }
+    return true;
+}
+
+static bool parseError(const std::string &filename,
+                       const TextCursor &cursor, const char *expected)
+{
+    fprintf(stderr, "%s:%zu: expected %s\n",
+            filename.c_str(), cursor.line, expected);
+    return false;
+}
+
+// reported as a throughput from that many bytes on
+static const size_t saveReportBytes = 1 << 20;
+
+static void appendNumber(std::string &buffer, const size_t number)
+{
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    buffer.append(digits, result.ptr);
+    buffer.push_back('\n');
+}
+
+// shortest representation reading back to the same float
+static void appendVertices(std::string &buffer,
+                           const std::vector<glm::vec3> &vertices)
+{
+    char line[64];
+
+    appendNumber(buffer, vertices.size());
+
+    for (const auto &vertex: vertices)
+    {
+        char *end = line + sizeof(line);
+        char *p = std::to_chars(line, end, vertex.x).ptr;
+        *p++ = ' ';
+        p = std::to_chars(p, end, vertex.y).ptr;
+        *p++ = ' ';
+        p = std::to_chars(p, end, vertex.z).ptr;
+        *p++ = '\n';
+        buffer.append(line, p);
+    }
+}
 
 DataModel::DataModel()
 {
@@ -64,81 +241,174 @@ void DataModel::deleteFile()
 
 bool DataModel::loadInputFile()
 {
-	GLfloat x, y, z;
-    short choice;
+    return this->loadInputFile(this->getFilename());
+}
 
-    std::ifstream ifs;
-    ifs.open(this->getFilename());
+bool DataModel::loadInputFile(const std::string &filename)
+{
+    std::string text;
+
+    if (ModelFile::isModelFile(filename))
+        return this->loadModelFile(filename);
 
-	if (!ifs.is_open())
-	{
+    if (!readFile(filename, text))
         return false;
-    }
 
-    ifs >> choice;
+    TextCursor cursor = {text.data(), text.data() + text.size(), 1};
+    uint32_t choice = 0;
+
+    this->profileVertices.clear();
+    this->trajectoryVertices.clear();
+    this->profilePoints = this->trajectoryPoints = this->spans = 0;
+
+    if (!parseCount(cursor, choice) || choice > 1)
+        return parseError(filename, cursor, "a sweep type (0 or 1)");
+
     if (choice == 0) // transitional
     {
         this->setSweepType(DataModel::SweepType::Translational);
-        ifs >> this->profilePoints;
-
-        for(unsigned int i = 0; i < this->profilePoints; i++)
-        {
-            ifs >> x >> y >> z;
-            this->profileVertices.push_back(glm::vec3(x, y, z));
-        }
 
-        ifs >> this->trajectoryPoints;
-
-        for(unsigned int i = 0; i < this->trajectoryPoints; i++)
-        {
-                ifs >> x >> y >> z;
-                this->trajectoryVertices.push_back(glm::vec3(x, y, z));
-        }
+        if (!parseCount(cursor, this->profilePoints))
+            return parseError(filename, cursor, "a profile points count");
+        if (!parseVertices(cursor, this->profilePoints,
+                           this->profileVertices))
+            return parseError(filename, cursor, "a profile vertex (x y z)");
+
+        if (!parseCount(cursor, this->trajectoryPoints))
+            return parseError(filename, cursor,
+                              "a trajectory points count");
+        if (!parseVertices(cursor, this->trajectoryPoints,
+                           this->trajectoryVertices))
+            return parseError(filename, cursor,
+                              "a trajectory vertex (x y z)");
     }
     else // rotational
     {
-        ifs >> this->spans;
-        ifs >> this->profilePoints;
-
-        for(unsigned int i = 0; i < this->profilePoints; i++)
-        {
-            ifs >> x >> y >> z;
-            this->profileVertices.push_back(glm::vec3(x, y, z));
-        }
+        this->setSweepType(DataModel::SweepType::Rotational);
+
+        if (!parseCount(cursor, this->spans))
+            return parseError(filename, cursor, "a spans count");
+        if (!parseCount(cursor, this->profilePoints))
+            return parseError(filename, cursor, "a profile points count");
+        if (!parseVertices(cursor, this->profilePoints,
+                           this->profileVertices))
+            return parseError(filename, cursor, "a profile vertex (x y z)");
     }
-    ifs.close();
     return true;
 }
 
-bool DataModel::saveNumber(const uint16_t number)
+bool DataModel::loadModelFile(const std::string &filename)
 {
-    std::fstream ofs;
+    ModelFile file;
 
-    ofs.open(this->getFilename(), std::fstream::out | std::fstream::app);
+    if (!file.open(filename))
+        return false;
 
-    if (!ofs.is_open())
+    if (file.profilePoints() > UINT32_MAX ||
+        file.trajectoryPoints() > UINT32_MAX)
+    {
         return false;
+    }
 
-    ofs << number << std::endl;
+    this->setSweepType(file.getSweepType());
+    this->spans = file.getSpans();
+    this->profilePoints = file.profilePoints();
+    this->trajectoryPoints = file.trajectoryPoints();
 
-    ofs.close();
+    this->profileVertices.assign(file.profile(),
+                                 file.profile() + file.profilePoints());
+    this->trajectoryVertices.assign(file.trajectory(),
+                                    file.trajectory() +
+                                    file.trajectoryPoints());
     return true;
 }
 
-bool DataModel::saveVertices(const std::vector<glm::vec3> vertices)
+void DataModel::serialize(std::string &buffer) const
+{
+    size_t vertices = this->profileVertices.size() +
+                      this->trajectoryVertices.size();
+
+    buffer.clear();
+    // about 3 floats of 8 digits and their separators per vertex
+    buffer.reserve(64 + vertices * 3 * 16);
+
+    appendNumber(buffer, this->sweepType);
+
+    if (this->sweepType == DataModel::SweepType::Rotational)
+    {
+        appendNumber(buffer, this->spans);
+        appendVertices(buffer, this->profileVertices);
+    }
+    else
+    {
+        appendVertices(buffer, this->profileVertices);
+        appendVertices(buffer, this->trajectoryVertices);
+    }
+}
+
+bool DataModel::saveFile()
+{
+    return this->saveFile(this->getFilename());
+}
+
+bool DataModel::saveFile(const std::string &filename)
 {
-    std::fstream ofs;
-    ofs.open(this->getFilename(), std::fstream::out | std::fstream::app);
+    auto start = std::chrono::steady_clock::now();
 
-    if (!ofs.is_open())
+    std::string buffer;
+    this->serialize(buffer);
+
+    // readers see either the previous file or the whole new one
+    std::string temporary = filename + ".tmp";
+
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", temporary.c_str(), strerror(errno));
         return false;
+    }
+
+    // the reason of the first failing call, not of the cleanup after it
+    int error = 0;
+
+    const char *data = buffer.data();
+    size_t left = buffer.size();
+    while (left > 0)
+    {
+        ssize_t written = write(fd, data, left);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+        {
+            error = (written < 0) ? errno : ENOSPC;
+            break;
+        }
+        data += written;
+        left -= written;
+    }
+
+    if (error == 0 && fsync(fd) != 0)
+        error = errno;
+    if (close(fd) != 0 && error == 0)
+        error = errno;
+    if (error == 0 && rename(temporary.c_str(), filename.c_str()) != 0)
+        error = errno;
+
+    if (error != 0)
+    {
+        unlink(temporary.c_str());
+        fprintf(stderr, "%s: %s\n", filename.c_str(), strerror(error));
+        return false;
+    }
 
-    ofs << vertices.size() << std::endl;
-    for (auto const &vertex: vertices)
+    if (this->verbose && buffer.size() >= saveReportBytes)
     {
-        ofs << vertex.x << " " << vertex.y << " " << vertex.z << std::endl;
+        double s = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        printf("Saved %.1f MB to %s at %.1f MB/s.\n",
+               buffer.size() / 1e6, filename.c_str(),
+               buffer.size() / 1e6 / s);
     }
-    ofs.close();
     return true;
 }
 
@@ -6,14 +6,17 @@
 #pragma once
 
 #include "stdio.h"
+#include <string.h>
 #include <iostream>
 
 #include <fstream>
 #include <iostream>
 
 #include <vector>
+#include <string>
+
+#include <stdint.h>
 
-#include <GL/glew.h>
 #include <glm/glm.hpp>
 
 class DataModel
@@ -38,16 +41,27 @@ class DataModel
         void deleteFile();
 
         bool loadInputFile();
-        bool saveNumber(const uint16_t number);
-        bool saveVertices(const std::vector<glm::vec3> vertices);
+        /*
+         * Text or binary ModelFile, told apart by the magic. A malformed
+         * text file is reported with its line number and returns false.
+        */
+        bool loadInputFile(const std::string &filename);
+        // copies out of the mapping, see ModelFile to use it in place
+        bool loadModelFile(const std::string &filename);
+        // text format, written at once to a temporary file renamed over
+        bool saveFile();
+        bool saveFile(const std::string &filename);
+        void serialize(std::string &buffer) const;
 
         void printInput();
 
         std::string fileSuffix;
+        // reports the throughput of large saves on stdout
+        bool verbose = true;
         SweepType sweepType;
-        uint16_t profilePoints = 0;
-        uint16_t trajectoryPoints = 0;
-        uint16_t spans = 0;
+        uint32_t profilePoints = 0;
+        uint32_t trajectoryPoints = 0;
+        uint32_t spans = 0;
         std::vector<glm::vec3> profileVertices;
         std::vector<glm::vec3> trajectoryVertices;
 };
@@ -0,0 +1,146 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "FrameProfiler.hpp"
+
+#include <stdio.h>
+
+static const double reportSeconds = 1.0;
+
+static const char* phaseNames[FrameProfiler::Phase::Phases] = {
+    "events", "uniforms", "draw", "swap"
+};
+
+FrameProfiler::FrameProfiler()
+{
+    glGenQueries(2, this->queries);
+    this->pending[0] = this->pending[1] = false;
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    glDeleteQueries(2, this->queries);
+}
+
+bool FrameProfiler::isEnabled() const
+{
+    return this->enabled;
+}
+
+void FrameProfiler::setEnabled(const bool enabled)
+{
+    this->enabled = enabled;
+
+    // rolling statistics start over
+    this->frames.clear();
+    this->gpu.clear();
+    for (auto &phase: this->phases)
+        phase.clear();
+    this->pending[0] = this->pending[1] = false;
+    this->lastReport = Clock::now();
+
+    printf("Frame profiler %s.\n", enabled ? "on" : "off");
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (!this->enabled)
+        return;
+
+    this->frameStart = this->lastMark = Clock::now();
+}
+
+void FrameProfiler::mark(const FrameProfiler::Phase phase)
+{
+    if (!this->enabled)
+        return;
+
+    Clock::time_point now = Clock::now();
+    this->phases[phase].add(
+        std::chrono::duration<double, std::milli>(now - this->lastMark).count());
+    this->lastMark = now;
+}
+
+void FrameProfiler::beginGpu()
+{
+    if (!this->enabled)
+        return;
+
+    size_t query = this->frame % 2;
+
+    // two frames late: dropped rather than waited for
+    this->collectGpu(query);
+    this->pending[query] = false;
+
+    glBeginQuery(GL_TIME_ELAPSED, this->queries[query]);
+}
+
+void FrameProfiler::endGpu()
+{
+    if (!this->enabled)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    this->pending[this->frame % 2] = true;
+}
+
+void FrameProfiler::collectGpu(const size_t query)
+{
+    GLint available = 0;
+    GLuint64 ns = 0;
+
+    if (!this->pending[query])
+        return;
+
+    glGetQueryObjectiv(this->queries[query], GL_QUERY_RESULT_AVAILABLE,
+                       &available);
+    if (!available)
+        return;
+
+    glGetQueryObjectui64v(this->queries[query], GL_QUERY_RESULT, &ns);
+    this->gpu.add(ns / 1e6);
+    this->pending[query] = false;
+}
+
+void FrameProfiler::endFrame(const DrawStats &draws)
+{
+    if (!this->enabled)
+        return;
+
+    Clock::time_point now = Clock::now();
+    this->frames.add(
+        std::chrono::duration<double, std::milli>(now - this->frameStart).count());
+    this->draws = draws;
+
+    // the previous frame's query, most likely done by now
+    this->frame++;
+    this->collectGpu(this->frame % 2);
+
+    if (std::chrono::duration<double>(now - this->lastReport).count() >=
+        reportSeconds)
+    {
+        this->report();
+        this->lastReport = now;
+    }
+}
+
+void FrameProfiler::report()
+{
+    printf("frame %.3f ms (p99 %.3f) x %zu |",
+           this->frames.average(), this->frames.percentile(99),
+           this->frames.count());
+    for (size_t p = 0; p < FrameProfiler::Phase::Phases; p++)
+        printf(" %s %.3f", phaseNames[p], this->phases[p].average());
+    printf(" | gpu %.3f ms (p99 %.3f) | "
+           "%zu draw(s), %zu vertices, %zu triangles\n",
+           this->gpu.average(), this->gpu.percentile(99),
+           this->draws.drawCalls, this->draws.vertices,
+           this->draws.triangles);
+
+    this->frames.clear();
+    this->gpu.clear();
+    for (auto &phase: this->phases)
+        phase.clear();
+}
@@ -0,0 +1,71 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Cpu time per phase and gpu time per frame, printed once a second
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include "FrameStats.hpp"
+
+// what a mesh submitted for its last frame
+struct DrawStats
+{
+    size_t drawCalls = 0;
+    size_t vertices = 0;
+    size_t triangles = 0;
+};
+
+/*
+ * The gpu time of a frame comes from a GL_TIME_ELAPSED query read
+ * back a frame later, if ready by then, so it never stalls the
+ * pipeline. Does nothing while disabled.
+*/
+class FrameProfiler
+{
+    public:
+        enum Phase {
+            Events = 0,
+            Uniforms = 1,
+            Draw = 2,
+            Swap = 3,
+            Phases = 4
+        };
+
+        FrameProfiler();
+        ~FrameProfiler();
+
+        bool isEnabled() const;
+        void setEnabled(const bool enabled);
+
+        void beginFrame();
+        // the time since the previous mark goes to that phase
+        void mark(const Phase phase);
+        void beginGpu();
+        void endGpu();
+        void endFrame(const DrawStats &draws);
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        void collectGpu(const size_t query);
+        void report();
+
+        bool enabled = false;
+        GLuint queries[2];
+        bool pending[2];
+        size_t frame = 0;
+        Clock::time_point frameStart;
+        Clock::time_point lastMark;
+        Clock::time_point lastReport;
+        FrameStats frames;
+        FrameStats phases[Phases];
+        FrameStats gpu;
+        DrawStats draws;
+};
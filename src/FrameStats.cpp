@@ -0,0 +1,81 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "FrameStats.hpp"
+
+#include <stdio.h>
+#include <math.h>
+
+#include <algorithm>
+
+FrameStats::FrameStats()
+{
+}
+
+FrameStats::~FrameStats()
+{
+}
+
+void FrameStats::add(const double ms)
+{
+    this->times.push_back(ms);
+}
+
+void FrameStats::clear()
+{
+    this->times.clear();
+}
+
+size_t FrameStats::count() const
+{
+    return this->times.size();
+}
+
+double FrameStats::min() const
+{
+    if (this->times.empty())
+        return 0;
+    return *std::min_element(this->times.begin(), this->times.end());
+}
+
+double FrameStats::max() const
+{
+    if (this->times.empty())
+        return 0;
+    return *std::max_element(this->times.begin(), this->times.end());
+}
+
+double FrameStats::average() const
+{
+    double sum = 0;
+
+    if (this->times.empty())
+        return 0;
+
+    for (double ms: this->times)
+        sum += ms;
+    return sum / this->times.size();
+}
+
+double FrameStats::percentile(const double p) const
+{
+    if (this->times.empty())
+        return 0;
+
+    std::vector<double> sorted(this->times);
+    size_t rank = (size_t) ceil(p / 100.0 * sorted.size());
+    rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+
+    std::nth_element(sorted.begin(), sorted.begin() + rank - 1,
+                     sorted.end());
+    return sorted[rank - 1];
+}
+
+void FrameStats::print(const char *label) const
+{
+    printf("%s: %zu frames, min %.3f / avg %.3f / p99 %.3f / max %.3f ms\n",
+           label, this->count(), this->min(), this->average(),
+           this->percentile(99), this->max());
+}
@@ -0,0 +1,34 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Frame time statistics (no OpenGL)
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+class FrameStats
+{
+    public:
+        FrameStats();
+        ~FrameStats();
+
+        void add(const double ms);
+        void clear();
+
+        size_t count() const;
+        double min() const;
+        double max() const;
+        double average() const;
+        // p in [0, 100], nearest rank
+        double percentile(const double p) const;
+
+        // "<label>: n frames, min / avg / p99 ms" on stdout
+        void print(const char *label) const;
+
+    private:
+        std::vector<double> times;
+};
@@ -0,0 +1,63 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "FrameUniforms.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+// std140: a mat4 is 4 vec4 columns, 64 bytes, no padding between
+static const GLintptr viewOffset = 0;
+static const GLintptr projectionOffset = sizeof(glm::mat4);
+
+const char* FrameUniforms::blockName()
+{
+    return "Frame";
+}
+
+FrameUniforms::FrameUniforms()
+{
+    glGenBuffers(1, &this->uboId);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->uboId);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL,
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, FrameUniforms::binding, this->uboId);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    glDeleteBuffers(1, &this->uboId);
+}
+
+void FrameUniforms::update(const glm::mat4 &view,
+                           const glm::mat4 &projection)
+{
+    bool viewChanged = !this->uploaded || view != this->view;
+    bool projectionChanged = !this->uploaded ||
+                             projection != this->projection;
+
+    if (!viewChanged && !projectionChanged)
+        return;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->uboId);
+
+    if (viewChanged)
+    {
+        glBufferSubData(GL_UNIFORM_BUFFER, viewOffset, sizeof(glm::mat4),
+                        glm::value_ptr(view));
+        this->view = view;
+    }
+    if (projectionChanged)
+    {
+        glBufferSubData(GL_UNIFORM_BUFFER, projectionOffset,
+                        sizeof(glm::mat4), glm::value_ptr(projection));
+        this->projection = projection;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    this->uploaded = true;
+}
@@ -0,0 +1,39 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Per frame uniforms shared by every shader as a std140 block
+*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+/*
+ * Matches, in any shader bound to it with Shader::bindUniformBlock:
+ *
+ *  layout (std140) uniform Frame
+ *  {
+ *      mat4 view;
+ *      mat4 projection;
+ *  };
+*/
+class FrameUniforms
+{
+    public:
+        static const GLuint binding = 0;
+        static const char* blockName();
+
+        FrameUniforms();
+        ~FrameUniforms();
+
+        // uploads only what changed since the last frame
+        void update(const glm::mat4 &view, const glm::mat4 &projection);
+
+    private:
+        GLuint uboId;
+        glm::mat4 view;
+        glm::mat4 projection;
+        bool uploaded = false;
+};
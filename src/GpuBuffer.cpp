@@ -0,0 +1,90 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "GpuBuffer.hpp"
+
+// smallest storage allocated, a few hundred vertices
+static const size_t minCapacity = 4096;
+
+GpuBuffer::GpuBuffer(const GLenum target) :
+    target(target),
+    id(0),
+    bytes(0),
+    allocated(0),
+    valid(0)
+{
+    glGenBuffers(1, &this->id);
+}
+
+GpuBuffer::~GpuBuffer()
+{
+    glDeleteBuffers(1, &this->id);
+}
+
+GLuint GpuBuffer::getId() const
+{
+    return this->id;
+}
+
+size_t GpuBuffer::size() const
+{
+    return this->bytes;
+}
+
+size_t GpuBuffer::capacity() const
+{
+    return this->allocated;
+}
+
+void GpuBuffer::invalidate()
+{
+    this->valid = 0;
+}
+
+size_t GpuBuffer::upload(const void *data, const size_t bytes)
+{
+    size_t from = (this->valid < bytes) ? this->valid : bytes;
+
+    this->bytes = bytes;
+    this->valid = bytes;
+
+    if (from == bytes)
+        return 0;
+
+    glBindBuffer(this->target, this->id);
+
+    if (bytes > this->allocated)
+    {
+        size_t capacity = this->allocated ? this->allocated : minCapacity;
+        while (capacity < bytes)
+            capacity *= 2;
+
+        // new storage, the previous one is orphaned with its content
+        glBufferData(this->target, capacity, NULL, GL_DYNAMIC_DRAW);
+        this->allocated = capacity;
+        from = 0;
+    }
+    glBufferSubData(this->target, from, bytes - from,
+                    (const char*) data + from);
+
+    return bytes - from;
+}
+
+size_t GpuBuffer::update(const void *data, const size_t offset,
+                         const size_t bytes)
+{
+    // past the valid prefix, left to the next upload()
+    if (offset >= this->valid)
+        return 0;
+
+    size_t end = (offset + bytes < this->valid) ? offset + bytes :
+                                                  this->valid;
+
+    glBindBuffer(this->target, this->id);
+    glBufferSubData(this->target, offset, end - offset,
+                    (const char*) data + offset);
+
+    return end - offset;
+}
@@ -0,0 +1,47 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief OpenGL buffer growing geometrically, updated by changed range
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <GL/glew.h>
+
+/*
+ * Keeps track of the prefix of its content already on the gpu:
+ * appending to the data uploads the new bytes only and the storage
+ * doubles when full, so n appends cost O(n) uploads in total.
+ * Anything else changing the data has to invalidate() it first.
+*/
+class GpuBuffer
+{
+    public:
+        GpuBuffer(const GLenum target);
+        ~GpuBuffer();
+
+        GLuint getId() const;
+        size_t size() const;
+        size_t capacity() const;
+
+        // the whole content is uploaded again on the next upload()
+        void invalidate();
+        // the data past the valid prefix, returns the bytes uploaded
+        size_t upload(const void *data, const size_t bytes);
+        /*
+         * Bytes [offset, offset + bytes) of the content at data changed
+         * in place, uploads the valid ones of them only.
+        */
+        size_t update(const void *data, const size_t offset,
+                      const size_t bytes);
+
+    private:
+        GLenum target;
+        GLuint id;
+        size_t bytes;
+        size_t allocated;
+        // bytes of the content known to match the gpu
+        size_t valid;
+};
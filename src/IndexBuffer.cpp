@@ -0,0 +1,189 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "IndexBuffer.hpp"
+
+IndexBuffer::IndexBuffer() :
+    topology(IndexBuffer::Topology::Triangles),
+    width(IndexBuffer::Width::U16)
+{
+}
+
+IndexBuffer::~IndexBuffer()
+{
+}
+
+IndexBuffer::Topology IndexBuffer::getTopology() const
+{
+    return this->topology;
+}
+
+void IndexBuffer::setTopology(const IndexBuffer::Topology topology)
+{
+    this->topology = topology;
+}
+
+uint32_t IndexBuffer::restartIndex() const
+{
+    if (this->width == IndexBuffer::Width::U16)
+        return 0xFFFF;
+    return 0xFFFFFFFF;
+}
+
+IndexBuffer::Width IndexBuffer::getWidth() const
+{
+    return this->width;
+}
+
+size_t IndexBuffer::size() const
+{
+    if (this->width == IndexBuffer::Width::U16)
+        return this->indices16.size();
+    return this->indices32.size();
+}
+
+size_t IndexBuffer::bytes() const
+{
+    return this->size() * this->width;
+}
+
+bool IndexBuffer::empty() const
+{
+    return this->size() == 0;
+}
+
+const void* IndexBuffer::data() const
+{
+    if (this->empty())
+        return NULL;
+    if (this->width == IndexBuffer::Width::U16)
+        return &this->indices16[0];
+    return &this->indices32[0];
+}
+
+uint32_t IndexBuffer::at(const size_t i) const
+{
+    uint32_t baseVertex = 0;
+
+    for (const auto &meshlet: this->meshlets)
+    {
+        if (i < meshlet.firstIndex + meshlet.indexCount)
+        {
+            baseVertex = meshlet.baseVertex;
+            break;
+        }
+    }
+    return baseVertex + this->local(i);
+}
+
+uint32_t IndexBuffer::local(const size_t i) const
+{
+    if (this->width == IndexBuffer::Width::U16)
+        return this->indices16[i];
+    return this->indices32[i];
+}
+
+size_t IndexBuffer::triangleCount() const
+{
+    if (this->topology == IndexBuffer::Topology::Triangles)
+        return this->size() / 3;
+
+    uint32_t restart = this->restartIndex();
+    size_t count = 0;
+
+    for (const auto &meshlet: this->meshlets)
+    {
+        size_t strip = 0;
+
+        for (size_t i = meshlet.firstIndex;
+             i < meshlet.firstIndex + meshlet.indexCount; i++)
+        {
+            if (this->local(i) == restart)
+                strip = 0;
+            else if (++strip >= 3)
+                count++;
+        }
+    }
+    return count;
+}
+
+void IndexBuffer::triangles(std::vector<uint32_t> &triangles) const
+{
+    uint32_t restart = this->restartIndex();
+
+    triangles.clear();
+
+    for (const auto &meshlet: this->meshlets)
+    {
+        size_t last = meshlet.firstIndex + meshlet.indexCount;
+
+        if (this->topology == IndexBuffer::Topology::Triangles)
+        {
+            for (size_t i = meshlet.firstIndex; i < last; i++)
+                triangles.push_back(meshlet.baseVertex + this->local(i));
+            continue;
+        }
+
+        // strip: every index after the first two closes a triangle
+        size_t strip = 0;
+        uint32_t a = 0, b = 0;
+
+        for (size_t i = meshlet.firstIndex; i < last; i++)
+        {
+            uint32_t index = this->local(i);
+
+            if (index == restart)
+            {
+                strip = 0;
+                continue;
+            }
+            index += meshlet.baseVertex;
+
+            if (strip >= 2)
+            {
+                // odd triangles are flipped back to the strip winding
+                triangles.push_back((strip % 2) ? b : a);
+                triangles.push_back((strip % 2) ? a : b);
+                triangles.push_back(index);
+            }
+            a = b;
+            b = index;
+            strip++;
+        }
+    }
+}
+
+void IndexBuffer::clear()
+{
+    this->indices16.clear();
+    this->indices32.clear();
+    this->meshlets.clear();
+}
+
+void IndexBuffer::resize(const IndexBuffer::Width width, const size_t count)
+{
+    this->width = width;
+
+    if (width == IndexBuffer::Width::U16)
+    {
+        this->indices32.clear();
+        this->indices16.resize(count);
+    }
+    else
+    {
+        this->indices16.clear();
+        this->indices32.resize(count);
+    }
+}
+
+uint16_t* IndexBuffer::u16()
+{
+    return this->indices16.empty() ? NULL : &this->indices16[0];
+}
+
+uint32_t* IndexBuffer::u32()
+{
+    return this->indices32.empty() ? NULL : &this->indices32[0];
+}
@@ -0,0 +1,75 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Triangle indices stored as 16 or 32 bits (no OpenGL)
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// a range of indices relative to its own base vertex
+struct Meshlet
+{
+    uint32_t baseVertex;
+    size_t firstIndex;
+    size_t indexCount;
+};
+
+class IndexBuffer
+{
+    public:
+        enum Width {
+            U16 = 2,
+            U32 = 4
+        };
+
+        enum Topology {
+            Triangles = 0,
+            // joined by primitive restart indices
+            TriangleStrip = 1
+        };
+
+        IndexBuffer();
+        ~IndexBuffer();
+
+        Topology getTopology() const;
+        void setTopology(const Topology topology);
+        // the all ones index of the current width
+        uint32_t restartIndex() const;
+
+        Width getWidth() const;
+        size_t size() const;
+        size_t bytes() const;
+        bool empty() const;
+        const void* data() const;
+
+        // absolute vertex index, meshlet base vertex included
+        uint32_t at(const size_t i) const;
+        // index as stored, relative to its meshlet base vertex
+        uint32_t local(const size_t i) const;
+
+        // triangles drawn, restart indices and strip starts excluded
+        size_t triangleCount() const;
+
+        // absolute indices as a triangle list, whatever the topology
+        void triangles(std::vector<uint32_t> &triangles) const;
+
+        void clear();
+        void resize(const Width width, const size_t count);
+
+        uint16_t* u16();
+        uint32_t* u32();
+
+        // always covers every index, one meshlet when not split
+        std::vector<Meshlet> meshlets;
+
+    private:
+        Topology topology;
+        Width width;
+        std::vector<uint16_t> indices16;
+        std::vector<uint32_t> indices32;
+};
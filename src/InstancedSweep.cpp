@@ -0,0 +1,123 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "InstancedSweep.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "FrameUniforms.hpp"
+
+// texture units of the buffers
+static const GLint profileUnit = 0;
+static const GLint transformsUnit = 1;
+
+InstancedSweep::InstancedSweep() :
+    profileBuffer(GL_TEXTURE_BUFFER),
+    transformsBuffer(GL_TEXTURE_BUFFER)
+{
+    this->shader = Shader::acquire(
+        "src/shaders/sweep.vs",
+        "src/shaders/default.fs");
+
+    this->modelLoc = this->shader->getUniformLocation("model");
+    this->rotationalLoc = this->shader->getUniformLocation("rotational");
+    this->shader->bindUniformBlock(FrameUniforms::blockName(),
+                                   FrameUniforms::binding);
+
+    // samplers and colorize never change
+    this->shader->use();
+    glUniform1i(this->shader->getUniformLocation("profile"), profileUnit);
+    glUniform1i(this->shader->getUniformLocation("transforms"),
+                transformsUnit);
+    glUniform1i(this->shader->getUniformLocation("colorize"), 1);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &this->vaoId);
+    glGenTextures(1, &this->profileTexture);
+    glGenTextures(1, &this->transformsTexture);
+}
+
+InstancedSweep::~InstancedSweep()
+{
+    glDeleteTextures(1, &this->transformsTexture);
+    glDeleteTextures(1, &this->profileTexture);
+    glDeleteVertexArrays(1, &this->vaoId);
+    Shader::release(this->shader);
+}
+
+// the texture follows its buffer whenever the storage is reallocated
+static void attach(const GLuint texture, const GpuBuffer &buffer)
+{
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer.getId());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void InstancedSweep::uploadProfile(const std::vector<glm::vec3> &profile)
+{
+    this->texels.resize(profile.size());
+    for (size_t p = 0; p < profile.size(); p++)
+        this->texels[p] = glm::vec4(profile[p], 0);
+
+    this->profileSize = profile.size();
+    this->profileBuffer.invalidate();
+    this->profileBuffer.upload(this->texels.empty() ? NULL : &this->texels[0],
+                               sizeof(glm::vec4) * this->texels.size());
+    attach(this->profileTexture, this->profileBuffer);
+}
+
+void InstancedSweep::uploadTransforms(
+    const DataModel::SweepType sweepType,
+    const std::vector<glm::vec4> &transforms)
+{
+    this->copies = transforms.size();
+    this->transformsBuffer.invalidate();
+    this->transformsBuffer.upload(
+        transforms.empty() ? NULL : &transforms[0],
+        sizeof(glm::vec4) * transforms.size());
+    attach(this->transformsTexture, this->transformsBuffer);
+
+    this->shader->use();
+    glUniform1i(this->rotationalLoc,
+                sweepType == DataModel::SweepType::Rotational);
+    glUseProgram(0);
+}
+
+void InstancedSweep::setModel(const glm::mat4 &model)
+{
+    this->shader->use();
+    glUniformMatrix4fv(this->modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+}
+
+void InstancedSweep::draw(const GLenum renderMode, DrawStats &stats)
+{
+    stats = DrawStats();
+
+    if (this->profileSize < 2 || this->copies < 2)
+        return;
+
+    GLenum mode = (renderMode == GL_TRIANGLES) ? GL_TRIANGLE_STRIP :
+                                                 renderMode;
+    GLsizei vertices = 2 * this->profileSize;
+    GLsizei instances = this->copies - 1;
+
+    this->shader->use();
+
+    glActiveTexture(GL_TEXTURE0 + profileUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, this->profileTexture);
+    glActiveTexture(GL_TEXTURE0 + transformsUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, this->transformsTexture);
+
+    glBindVertexArray(this->vaoId);
+    glDrawArraysInstanced(mode, 0, vertices, instances);
+    glBindVertexArray(0);
+
+    glActiveTexture(GL_TEXTURE0);
+
+    stats.drawCalls = 1;
+    stats.vertices = (size_t) vertices * instances;
+    if (mode != GL_POINTS)
+        stats.triangles = (size_t) (vertices - 2) * instances;
+}
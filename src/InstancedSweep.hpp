@@ -0,0 +1,51 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Sweep surface built in the vertex shader from its profile
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "Shader.hpp"
+#include "GpuBuffer.hpp"
+#include "DataModel.hpp"
+#include "FrameProfiler.hpp"
+
+/*
+ * Holds the tessellated profile and one transform per profile copy
+ * (see Sweeper::sweepTransforms) in texture buffers, O(profile + sweeps)
+ * instead of O(profile x sweeps), and draws a triangle strip instance
+ * per sweep.
+*/
+class InstancedSweep
+{
+    public:
+        InstancedSweep();
+        ~InstancedSweep();
+
+        void uploadProfile(const std::vector<glm::vec3> &profile);
+        void uploadTransforms(const DataModel::SweepType sweepType,
+                              const std::vector<glm::vec4> &transforms);
+
+        void setModel(const glm::mat4 &model);
+        // GL_TRIANGLES draws the strips
+        void draw(const GLenum renderMode, DrawStats &stats);
+
+    private:
+        Shader *shader;
+        GLint modelLoc, rotationalLoc;
+        // attribute-less, vertices come from gl_VertexID
+        GLuint vaoId;
+        GpuBuffer profileBuffer, transformsBuffer;
+        GLuint profileTexture, transformsTexture;
+        // texel aligned copy of the profile
+        std::vector<glm::vec4> texels;
+        size_t profileSize = 0;
+        size_t copies = 0;
+};
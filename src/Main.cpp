@@ -4,8 +4,16 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <iostream>
 #include <assert.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -15,17 +23,59 @@
 #include "Shader.hpp"
 #include "Camera.hpp"
 #include "Spline.hpp"
+#include "FrameUniforms.hpp"
+#include "FrameStats.hpp"
+#include "FrameProfiler.hpp"
+#include "Scene.hpp"
+#include "AllocationCounter.hpp"
 
 Window* window;
 Shader* shader;
 Camera* camera;
 Spline* mesh;
+FrameUniforms* frameUniforms;
+FrameProfiler* profiler;
+// drawn instead of the mesh when given models
+Scene* scene = NULL;
 
 GLenum polygonMode = GL_FILL;
 
 glm::mat4 view;
 glm::mat4 projection;
 
+bool weldVertices = false;
+bool triangleStrips = false;
+bool instancedSweep = false;
+// shaded with the analytic normals, --lit
+bool litSurface = false;
+// coarser surfaces drawn when small on screen, --lod <levels>
+size_t lodLevels = 3;
+// needs a GL 4.0 context, 3.3 without it
+bool tessellatedSweep = false;
+
+// --stream <capacity>: control points read from stdin by readStream()
+size_t streamCapacity = 0;
+std::mutex streamMutex;
+std::deque<glm::vec3> streamPoints;
+
+// --scene <data file> (any number of times), --copies <n> of each
+std::vector<std::string> sceneFiles;
+size_t sceneCopies = 1;
+bool sceneIndirect = true;
+DrawStats sceneStats;
+
+// frames are drawn on events only, unless animating or benchmarking
+bool redraw = true;
+int swapInterval = 1;
+// B key or --benchmark <frames>: that many frames without vsync
+size_t benchmarkLength = 1000;
+size_t benchmarkFrames = 0;
+FrameStats benchmarkStats;
+
+// launch (or the end of the menu prompts) to the first frame swapped
+std::chrono::steady_clock::time_point startupTime;
+bool firstFrameSwapped = false;
+
 bool resetDraw = false;
 bool printCursorCoordinates = false;
 uint8_t keyEnterCounter = 0;
@@ -33,6 +83,14 @@ uint8_t keyEnterCounter = 0;
 bool mouseLeftPress = false;
 glm::vec3 posCursorClick;
 
+// right drag in stage three: the control point following the cursor
+bool mouseRightPress = false;
+Spline::DrawStage dragCurve;
+size_t dragPoint = 0;
+glm::vec2 dragCursor;
+// pixels around a control point picking it
+const float pickRadius = 10.0f;
+
 // Callbacks
 void key_callback(GLFWwindow *w, int key, int scancode, int action, int mode);
 
@@ -42,6 +100,58 @@ void mouse_scroll_callback(GLFWwindow *w, double xoffset, double yoffset);
 
 void framebuffer_size_callback(GLFWwindow* w, int width, int height);
 
+void window_refresh_callback(GLFWwindow* w);
+
+void startBenchmark()
+{
+    benchmarkStats.clear();
+    benchmarkFrames = benchmarkLength;
+    glfwSwapInterval(0);
+    printf("Benchmark: drawing %zu frames unthrottled..\n", benchmarkLength);
+}
+
+void stopBenchmark()
+{
+    benchmarkFrames = 0;
+    glfwSwapInterval(swapInterval);
+    benchmarkStats.print("Benchmark");
+}
+
+// "x y z" lines, until the end of the input
+void readStream()
+{
+    char line[256];
+    glm::vec3 p;
+
+    while (fgets(line, sizeof(line), stdin))
+    {
+        if (sscanf(line, "%f %f %f", &p.x, &p.y, &p.z) != 3)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(streamMutex);
+            // the oldest would leave the ring before being drawn
+            if (streamPoints.size() >= streamCapacity)
+                streamPoints.pop_front();
+            streamPoints.push_back(p);
+        }
+        glfwPostEmptyEvent();
+    }
+}
+
+// true if any control point was appended
+bool drainStream()
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+
+    if (streamPoints.empty())
+        return false;
+
+    for (const auto &p: streamPoints)
+        mesh->appendControlPoint(p);
+    streamPoints.clear();
+    return true;
+}
+
 glm::vec3 getScreenCoordinates(const bool normalize)
 {
     double cursorX, cursorY;
@@ -103,13 +213,27 @@ glm::vec3 normalizedToScreenCoordinates(const glm::vec3 npos)
 void initApplication(const DataModel::SweepType sweepType)
 {
     camera = new Camera();
-    window = new Window(800, 800, "Sweeping Splines");
+    if (tessellatedSweep)
+    {
+        window = new Window(800, 800, "Sweeping Splines", 4, 0);
+        if (!window->get())
+        {
+            printf("No OpenGL 4.0 context, tessellation disabled.\n");
+            tessellatedSweep = false;
+            delete window;
+        }
+    }
+    if (!tessellatedSweep)
+        window = new Window(800, 800, "Sweeping Splines");
 
     // FIXME move into window but allow them to access mesh?
     glfwSetKeyCallback(window->get(), key_callback);
     glfwSetMouseButtonCallback(window->get(), mouse_key_callback);
     glfwSetFramebufferSizeCallback(window->get(), framebuffer_size_callback);
     glfwSetScrollCallback(window->get(), mouse_scroll_callback);
+    glfwSetWindowRefreshCallback(window->get(), window_refresh_callback);
+
+    glfwSwapInterval(swapInterval);
 
     glewExperimental = GL_TRUE;
     glewInit();
@@ -119,8 +243,18 @@ void initApplication(const DataModel::SweepType sweepType)
 
     glViewport(0, 0, window->width(), window->height());
 
+    frameUniforms = new FrameUniforms();
+    profiler = new FrameProfiler();
+
     mesh = new Spline();
     mesh->setSweepType(sweepType);
+    mesh->setWeld(weldVertices);
+    if (triangleStrips)
+        mesh->setTopology(IndexBuffer::Topology::TriangleStrip);
+    mesh->setInstanced(instancedSweep);
+    mesh->setTessellated(tessellatedSweep);
+    mesh->setLodLevels(lodLevels);
+    mesh->setLit(litSurface);
     mesh->setRenderMode(GL_POINTS);
 
     projection = glm::ortho(0.0f, (GLfloat) window->width(),
@@ -128,11 +262,61 @@ void initApplication(const DataModel::SweepType sweepType)
                             0.1f, 100.0f);
 }
 
+// make ALLOCATIONS=1: heap allocations of a regeneration, 0 once warm
+void reportAllocations(const char *regeneration, const size_t since)
+{
+    if (AllocationCounter::enabled())
+        printf("%s: %zu heap allocations.\n", regeneration,
+               AllocationCounter::allocations() - since);
+}
+
+// the models swept once, their copies laid on a square grid
+bool initScene()
+{
+    ThreadPool pool;
+    Sweeper sweeper;
+    sweeper.setThreadPool(&pool);
+
+    std::vector<SweepMesh> meshes(sceneFiles.size());
+    for (size_t f = 0; f < sceneFiles.size(); f++)
+    {
+        DataModel dataModel;
+        if (!dataModel.loadInputFile(sceneFiles[f]) ||
+            !sweeper.sweep(dataModel, meshes[f]))
+        {
+            printf("Cannot sweep %s.\n", sceneFiles[f].c_str());
+            return false;
+        }
+    }
+
+    scene = new Scene();
+    scene->setIndirect(sceneIndirect);
+
+    size_t models = meshes.size() * sceneCopies;
+    size_t columns = (size_t) ceil(sqrt((double) models));
+    float cell = 2.0f / columns;
+
+    for (size_t m = 0; m < models; m++)
+    {
+        glm::vec3 center(-1 + cell * (m % columns + 0.5f),
+                         1 - cell * (m / columns + 0.5f), 0);
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), center),
+                                     glm::vec3(0.45f * cell));
+        scene->add(meshes[m % meshes.size()], model);
+    }
+    scene->upload();
+
+    printf("Scene: %zu models in 1 draw call (%s).\n", models,
+           scene->isIndirect() ? "glMultiDrawElementsIndirect" :
+                                 "glMultiDrawElementsBaseVertex");
+    return true;
+}
+
 bool shellMenu(const std::string fileSuffix)
 {
     char choice;
     bool chosen = false;
-    uint16_t spans = 0;
+    uint32_t spans = 0;
     DataModel::SweepType sweepType;
 
     // handle sweep type
@@ -170,6 +354,8 @@ bool shellMenu(const std::string fileSuffix)
     }
 
     chosen = false;
+    // waiting for the answers above is not startup time
+    startupTime = std::chrono::steady_clock::now();
     initApplication(sweepType);
     mesh->setSpans(spans);
 
@@ -224,14 +410,79 @@ bool shellMenu(const std::string fileSuffix)
     return true;
 }
 
+/*
+ * Right click in stage three: drags the nearest control point, with
+ * shift a copy of it inserted after it, with control deletes it.
+*/
+void editControlPoint(const int mods)
+{
+    glm::vec3 pos = getScreenCoordinates(false);
+    glm::vec2 viewport(window->width(), window->height());
+    Spline::DrawStage curve;
+    size_t i;
+
+    if (!mesh->pickControlPoint(glm::vec2(pos.x, pos.y), view, projection,
+                                viewport, pickRadius, curve, i))
+        return;
+
+    size_t allocations = AllocationCounter::allocations();
+
+    if (mods & GLFW_MOD_CONTROL)
+    {
+        if (mesh->deleteControlPoint(curve, i))
+        {
+            reportAllocations("Delete", allocations);
+            mesh->saveData();
+        }
+        return;
+    }
+    if (mods & GLFW_MOD_SHIFT)
+    {
+        if (!mesh->insertControlPoint(curve, i + 1,
+                                      mesh->getControlPoint(curve, i)))
+            return;
+        reportAllocations("Insert", allocations);
+        i++;
+    }
+
+    dragCurve = curve;
+    dragPoint = i;
+    dragCursor = glm::vec2(pos.x, pos.y);
+    mouseRightPress = true;
+}
+
 void draw()
 {
     glm::vec3 lastPos;
     resetDraw = false;
+    redraw = true;
 
     while (!glfwWindowShouldClose(window->get()) || !resetDraw)
     {
-        glfwPollEvents();
+        auto frameStart = std::chrono::steady_clock::now();
+
+        // rotation drag and cursor printing follow the cursor every frame
+        if (redraw || mouseLeftPress || mouseRightPress ||
+            printCursorCoordinates || benchmarkFrames > 0)
+        {
+            profiler->beginFrame();
+            glfwPollEvents();
+        }
+        else
+        {
+            // sleeping is no part of a frame
+            glfwWaitEvents();
+            profiler->beginFrame();
+        }
+
+        if (streamCapacity && drainStream())
+            redraw = true;
+
+        if (!redraw && !mouseLeftPress && !mouseRightPress &&
+            !printCursorCoordinates && benchmarkFrames == 0)
+            continue;
+        redraw = false;
+        profiler->mark(FrameProfiler::Phase::Events);
 
         // projection matrix {
         if (mesh->getDrawStage() < Spline::DrawStage::THREE)
@@ -258,7 +509,32 @@ void draw()
 
         view = glm::translate(camera->view(), glm::vec3(0.0f, 0.0f, -3.0f));
 
-        mesh->render(window, camera, view, projection);
+        if (mouseRightPress)
+        {
+            glm::vec3 pos = getScreenCoordinates(false);
+            glm::vec2 cursor(pos.x, pos.y);
+
+            // only what the edited point reaches is swept again
+            if (cursor != dragCursor)
+                mesh->dragControlPoint(dragCurve, dragPoint, cursor, view,
+                                       projection,
+                                       glm::vec2(window->width(),
+                                                 window->height()));
+            dragCursor = cursor;
+        }
+
+        // once for every mesh of the frame
+        frameUniforms->update(view, projection);
+        mesh->selectLod(view, projection, window->height());
+        profiler->mark(FrameProfiler::Phase::Uniforms);
+
+        profiler->beginGpu();
+        if (scene)
+            scene->draw(mesh->getRenderMode(), sceneStats);
+        else
+            mesh->render(window, camera);
+        profiler->endGpu();
+        profiler->mark(FrameProfiler::Phase::Draw);
 
         if (printCursorCoordinates &&
             mesh->getDrawStage() < Spline::DrawStage::THREE)
@@ -281,11 +557,37 @@ void draw()
 
         // swap the screen buffers
         glfwSwapBuffers(window->get());
+        profiler->mark(FrameProfiler::Phase::Swap);
+
+        if (!firstFrameSwapped)
+        {
+            size_t compiled, cached;
+            Shader::getBuildCounts(compiled, cached);
+            printf("First frame after %.1f ms (programs: %zu compiled, "
+                   "%zu from cache).\n",
+                   std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - startupTime).count(),
+                   compiled, cached);
+            firstFrameSwapped = true;
+        }
+        profiler->endFrame(scene ? sceneStats : mesh->getDrawStats());
+
+        if (benchmarkFrames > 0)
+        {
+            benchmarkStats.add(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - frameStart).count());
+
+            if (--benchmarkFrames == 0)
+                stopBenchmark();
+        }
     }
-    if (resetDraw)
+    // nothing to ask for while stdin is streamed or a scene is shown
+    if (resetDraw && !streamCapacity && !scene)
     {
         delete camera;
         delete mesh;
+        delete frameUniforms;
+        delete profiler;
         delete window;
 
         std::string suffix;
@@ -305,9 +607,88 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    if (!shellMenu(argv[1]))
+    startupTime = std::chrono::steady_clock::now();
+
+    // $XDG_CACHE_HOME/sweeping-splines, or ~/.cache/sweeping-splines
+    std::string cacheHome;
+    if (getenv("XDG_CACHE_HOME"))
+        cacheHome = getenv("XDG_CACHE_HOME");
+    else if (getenv("HOME"))
+        cacheHome = std::string(getenv("HOME")) + "/.cache";
+    std::string shaderCache = cacheHome.empty() ? "" :
+                              cacheHome + "/sweeping-splines";
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--weld")
+            weldVertices = true;
+        else if (std::string(argv[i]) == "--strips")
+            triangleStrips = true;
+        else if (std::string(argv[i]) == "--instanced")
+            instancedSweep = true;
+        else if (std::string(argv[i]) == "--lit")
+            litSurface = true;
+        else if (std::string(argv[i]) == "--tessellation")
+            tessellatedSweep = true;
+        else if (std::string(argv[i]) == "--scene" && i + 1 < argc)
+            sceneFiles.push_back(argv[++i]);
+        else if (std::string(argv[i]) == "--copies" && i + 1 < argc)
+            sceneCopies = atol(argv[++i]);
+        else if (std::string(argv[i]) == "--no-indirect")
+            sceneIndirect = false;
+        else if (std::string(argv[i]) == "--stream" && i + 1 < argc)
+            streamCapacity = atol(argv[++i]);
+        else if (std::string(argv[i]) == "--lod" && i + 1 < argc)
+            lodLevels = atol(argv[++i]);
+        else if (std::string(argv[i]) == "--shader-cache" && i + 1 < argc)
+            shaderCache = argv[++i];
+        else if (std::string(argv[i]) == "--no-shader-cache")
+            shaderCache.clear();
+        else if (std::string(argv[i]) == "--swap-interval" && i + 1 < argc)
+            swapInterval = atoi(argv[++i]);
+        else if (std::string(argv[i]) == "--benchmark" && i + 1 < argc)
+        {
+            benchmarkLength = atol(argv[++i]);
+            benchmarkFrames = benchmarkLength;
+        }
+    }
+
+    // a weld leaves a single triangle list, see Welder
+    if (weldVertices && triangleStrips)
+    {
+        std::cout << "--weld draws a triangle list, not strips.." << std::endl;
+        return 1;
+    }
+
+    if (!shaderCache.empty())
+    {
+        mkdir(cacheHome.c_str(), 0755);
+        mkdir(shaderCache.c_str(), 0755);
+        Shader::setCacheDirectory(shaderCache);
+    }
+
+    if (!sceneFiles.empty())
+    {
+        initApplication(DataModel::SweepType::Rotational);
+        mesh->setDrawStage(Spline::DrawStage::THREE);
+        mesh->setRenderMode(GL_TRIANGLES);
+        if (!initScene())
+            return 1;
+    }
+    else if (streamCapacity)
+    {
+        initApplication(DataModel::SweepType::Translational);
+        mesh->setStreaming(streamCapacity);
+        mesh->setDrawStage(Spline::DrawStage::THREE);
+        mesh->setRenderMode(GL_LINE_STRIP);
+        std::thread(readStream).detach();
+    }
+    else if (!shellMenu(argv[1]))
         return 1;
 
+    if (benchmarkFrames > 0)
+        startBenchmark();
+
     draw();
 
     return 0;
@@ -321,12 +702,24 @@ void framebuffer_size_callback(GLFWwindow* w,
     window->width(width);
     window->height(height);
     glViewport(0, 0, width, height);
+    redraw = true;
+}
+
+void window_refresh_callback(GLFWwindow*)
+{
+    redraw = true;
 }
 
 void key_callback(GLFWwindow* w, int key, int scancode,
                   int action, int mode)
 {
     //printf("keyboard: %i\n", key);
+    redraw = true;
+
+    if (key == GLFW_KEY_B && action == GLFW_PRESS && benchmarkLength > 0)
+        startBenchmark();
+    if (key == GLFW_KEY_I && action == GLFW_PRESS)
+        profiler->setEnabled(!profiler->isEnabled());
 
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     {
@@ -368,19 +761,24 @@ void key_callback(GLFWwindow* w, int key, int scancode,
                         //else skip stage two for rotational
 
                     case Spline::DrawStage::TWO:
+                    {
                         mesh->setDrawStage(Spline::DrawStage::THREE);
 
                         mesh->uploadVertices();
                         mesh->saveData();
 
+                        size_t allocations = AllocationCounter::allocations();
                         mesh->sweep();
                         mesh->genSplinesIndices();
+                        mesh->weld();
 
                         mesh->uploadVertices();
+                        reportAllocations("Sweep", allocations);
 
                         polygonMode = GL_FILL;
                         mesh->setRenderMode(GL_TRIANGLES);
                         break;
+                    }
                 }
                 keyEnterCounter = 0;
             }
@@ -460,12 +858,33 @@ void key_callback(GLFWwindow* w, int key, int scancode,
             polygonMode = GL_FILL;
             mesh->setRenderMode(GL_TRIANGLES);
         }
+
+        // from 3 to 2^16 spans
+        bool rotational = (mesh->getSweepType() ==
+                           DataModel::SweepType::Rotational);
+
+        if (key == GLFW_KEY_M && action == GLFW_PRESS && rotational &&
+            mesh->getSpans() < 65536)
+        {
+            size_t allocations = AllocationCounter::allocations();
+            mesh->setSpans(mesh->getSpans() * 2);
+            reportAllocations("Spans", allocations);
+        }
+        if (key == GLFW_KEY_N && action == GLFW_PRESS && rotational &&
+            mesh->getSpans() > 3)
+        {
+            size_t allocations = AllocationCounter::allocations();
+            mesh->setSpans(std::max(mesh->getSpans() / 2, 3u));
+            reportAllocations("Spans", allocations);
+        }
     }
 }
 
 void mouse_key_callback(GLFWwindow* w, int key,
                         int action, int mode)
 {
+    redraw = true;
+
     if (key == GLFW_MOUSE_BUTTON_LEFT &&
         action == GLFW_PRESS &&
         keyEnterCounter == 0 &&
@@ -512,11 +931,26 @@ void mouse_key_callback(GLFWwindow* w, int key,
                     break;
             }
         }
+        if (key == GLFW_MOUSE_BUTTON_RIGHT && !scene &&
+            !mesh->isStreaming())
+        {
+            if (action == GLFW_PRESS)
+            {
+                editControlPoint(mode);
+            }
+            else if (action == GLFW_RELEASE && mouseRightPress)
+            {
+                mouseRightPress = false;
+                mesh->saveData();
+            }
+        }
     }
 }
 
 void mouse_scroll_callback(GLFWwindow *w, double xoffset, double yoffset)
 {
+    redraw = true;
+
     if (yoffset > 0)
         camera->moveForward();
     else if (yoffset < 0)
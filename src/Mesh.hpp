@@ -12,8 +12,7 @@ class Mesh
 
         virtual void setRenderMode(const GLenum renderMode) = 0;
 
+        // view and projection come from the bound FrameUniforms
         virtual void render(const Window* window,
-                            const Camera* camera,
-                            const glm::mat4 view,
-                            const glm::mat4 projection) = 0;
+                            const Camera* camera) = 0;
 };
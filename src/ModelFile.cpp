@@ -0,0 +1,402 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "ModelFile.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <vector>
+
+static const char modelFileMagic[8] = {'S', 'P', 'L', 'I', 'N', 'E', 'S', 0};
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float),
+              "vec3 arrays are stored packed");
+static_assert(sizeof(ModelFileHeader) == 112, "header layout");
+static_assert(sizeof(ModelFileMeshlet) == 24, "meshlet layout");
+
+static uint64_t alignOffset(const uint64_t offset)
+{
+    return (offset + ModelFile::alignment - 1) & ~(uint64_t)
+           (ModelFile::alignment - 1);
+}
+
+static bool writeArray(FILE *file, uint64_t &offset, const uint64_t at,
+                       const void *data, const size_t bytes)
+{
+    static const char padding[ModelFile::alignment] = {0};
+
+    if (at > offset &&
+        fwrite(padding, 1, at - offset, file) != at - offset)
+    {
+        return false;
+    }
+    offset = at + bytes;
+
+    return bytes == 0 || fwrite(data, 1, bytes, file) == bytes;
+}
+
+ModelFile::ModelFile() :
+    fd(-1),
+    base(NULL),
+    size(0),
+    header(NULL)
+{
+}
+
+ModelFile::~ModelFile()
+{
+    this->close();
+}
+
+bool ModelFile::open(const std::string &filename)
+{
+    struct stat st;
+
+    this->close();
+
+    this->fd = ::open(filename.c_str(), O_RDONLY);
+    if (this->fd < 0)
+        return false;
+
+    if (fstat(this->fd, &st) != 0 ||
+        (size_t) st.st_size < sizeof(ModelFileHeader))
+    {
+        this->close();
+        return false;
+    }
+    this->size = st.st_size;
+
+    void *mapping = mmap(NULL, this->size, PROT_READ, MAP_PRIVATE,
+                         this->fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        this->close();
+        return false;
+    }
+    this->base = (const uint8_t*) mapping;
+    this->header = (const ModelFileHeader*) mapping;
+
+    if (!this->validate())
+    {
+        fprintf(stderr, "%s: not a version %u model file\n",
+                filename.c_str(), ModelFile::version);
+        this->close();
+        return false;
+    }
+    // the control points are read once front to back
+    madvise(mapping, this->size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void ModelFile::close()
+{
+    if (this->base)
+        munmap((void*) this->base, this->size);
+    if (this->fd >= 0)
+        ::close(this->fd);
+
+    this->fd = -1;
+    this->base = NULL;
+    this->size = 0;
+    this->header = NULL;
+}
+
+bool ModelFile::isOpen() const
+{
+    return this->header != NULL;
+}
+
+bool ModelFile::isModelFile(const std::string &filename)
+{
+    char magic[sizeof(modelFileMagic)];
+
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+
+    bool found = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 memcmp(magic, modelFileMagic, sizeof(magic)) == 0;
+    fclose(file);
+    return found;
+}
+
+bool ModelFile::validate() const
+{
+    const ModelFileHeader &h = *this->header;
+
+    if (memcmp(h.magic, modelFileMagic, sizeof(modelFileMagic)) != 0 ||
+        h.version != ModelFile::version ||
+        h.sweepType > DataModel::SweepType::Rotational)
+    {
+        return false;
+    }
+
+    if (h.indices && h.indexWidth != IndexBuffer::Width::U16 &&
+                     h.indexWidth != IndexBuffer::Width::U32)
+    {
+        return false;
+    }
+    if (h.topology > IndexBuffer::Topology::TriangleStrip)
+        return false;
+
+    const uint64_t arrays[][3] = {
+        {h.profileOffset, h.profilePoints, sizeof(glm::vec3)},
+        {h.trajectoryOffset, h.trajectoryPoints, sizeof(glm::vec3)},
+        {h.verticesOffset, h.vertices, sizeof(glm::vec3)},
+        {h.indicesOffset, h.indices, h.indexWidth},
+        {h.meshletsOffset, h.meshlets, sizeof(ModelFileMeshlet)}
+    };
+
+    for (const auto &array: arrays)
+    {
+        uint64_t offset = array[0], count = array[1], stride = array[2];
+
+        if (count == 0)
+            continue;
+        if (offset % ModelFile::alignment != 0 || offset > this->size ||
+            count > (this->size - offset) / stride)
+        {
+            return false;
+        }
+    }
+
+    // a surface needs both its vertices and its indices, drawn by meshlets
+    if ((h.vertices == 0) != (h.indices == 0) ||
+        (h.indices && h.meshlets == 0))
+        return false;
+
+    return this->validateMeshlets();
+}
+
+bool ModelFile::validateMeshlets() const
+{
+    const ModelFileHeader &h = *this->header;
+    const ModelFileMeshlet *meshlets = this->meshlets();
+
+    // restart indices only separate strips
+    uint32_t restart = (h.indexWidth == IndexBuffer::Width::U16) ?
+        UINT16_MAX : UINT32_MAX;
+    bool strips = h.topology == IndexBuffer::Topology::TriangleStrip;
+
+    for (uint64_t m = 0; m < h.meshlets; m++)
+    {
+        const ModelFileMeshlet &meshlet = meshlets[m];
+
+        if (meshlet.firstIndex > h.indices ||
+            meshlet.indexCount > h.indices - meshlet.firstIndex ||
+            meshlet.baseVertex > UINT32_MAX)
+        {
+            return false;
+        }
+
+        uint64_t last = meshlet.firstIndex + meshlet.indexCount;
+        for (uint64_t i = meshlet.firstIndex; i < last; i++)
+        {
+            uint32_t index = (h.indexWidth == IndexBuffer::Width::U16) ?
+                ((const uint16_t*) this->indices())[i] :
+                ((const uint32_t*) this->indices())[i];
+
+            if (strips && index == restart)
+                continue;
+            if (meshlet.baseVertex + index >= h.vertices)
+                return false;
+        }
+    }
+    return true;
+}
+
+const void* ModelFile::at(const uint64_t offset) const
+{
+    return this->base + offset;
+}
+
+bool ModelFile::save(const std::string &filename,
+                     const DataModel &dataModel,
+                     const SweepMesh *mesh)
+{
+    ModelFileHeader h;
+    std::vector<ModelFileMeshlet> meshlets;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, modelFileMagic, sizeof(h.magic));
+    h.version = ModelFile::version;
+    h.sweepType = dataModel.getSweepType();
+    h.spans = dataModel.spans;
+
+    h.profilePoints = dataModel.profileVertices.size();
+    h.trajectoryPoints = dataModel.trajectoryVertices.size();
+
+    if (mesh && !mesh->vertices.empty() && !mesh->indices.empty())
+    {
+        h.indexWidth = mesh->indices.getWidth();
+        h.topology = mesh->indices.getTopology();
+        h.sweeps = mesh->sweeps;
+        h.vertices = mesh->vertices.size();
+        h.indices = mesh->indices.size();
+        h.meshlets = mesh->indices.meshlets.size();
+
+        for (const auto &meshlet: mesh->indices.meshlets)
+        {
+            ModelFileMeshlet m = {meshlet.baseVertex, meshlet.firstIndex,
+                                  meshlet.indexCount};
+            meshlets.push_back(m);
+        }
+    }
+
+    h.profileOffset = alignOffset(sizeof(h));
+    h.trajectoryOffset = alignOffset(h.profileOffset +
+                                     h.profilePoints * sizeof(glm::vec3));
+    h.verticesOffset = alignOffset(h.trajectoryOffset +
+                                   h.trajectoryPoints * sizeof(glm::vec3));
+    h.indicesOffset = alignOffset(h.verticesOffset +
+                                  h.vertices * sizeof(glm::vec3));
+    h.meshletsOffset = alignOffset(h.indicesOffset +
+                                   h.indices * h.indexWidth);
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+
+    uint64_t offset = 0;
+    bool written =
+        writeArray(file, offset, 0, &h, sizeof(h)) &&
+        writeArray(file, offset, h.profileOffset,
+                   h.profilePoints ? &dataModel.profileVertices[0] : NULL,
+                   h.profilePoints * sizeof(glm::vec3)) &&
+        writeArray(file, offset, h.trajectoryOffset,
+                   h.trajectoryPoints ? &dataModel.trajectoryVertices[0] :
+                                        NULL,
+                   h.trajectoryPoints * sizeof(glm::vec3));
+
+    if (written && h.vertices)
+    {
+        written =
+            writeArray(file, offset, h.verticesOffset, &mesh->vertices[0],
+                       h.vertices * sizeof(glm::vec3)) &&
+            writeArray(file, offset, h.indicesOffset, mesh->indices.data(),
+                       mesh->indices.bytes()) &&
+            writeArray(file, offset, h.meshletsOffset, &meshlets[0],
+                       meshlets.size() * sizeof(ModelFileMeshlet));
+    }
+
+    return (fclose(file) == 0) && written;
+}
+
+DataModel::SweepType ModelFile::getSweepType() const
+{
+    return (DataModel::SweepType) this->header->sweepType;
+}
+
+size_t ModelFile::getSpans() const
+{
+    return this->header->spans;
+}
+
+size_t ModelFile::bytes() const
+{
+    return this->size;
+}
+
+const glm::vec3* ModelFile::profile() const
+{
+    return (const glm::vec3*) this->at(this->header->profileOffset);
+}
+
+size_t ModelFile::profilePoints() const
+{
+    return this->header->profilePoints;
+}
+
+const glm::vec3* ModelFile::trajectory() const
+{
+    return (const glm::vec3*) this->at(this->header->trajectoryOffset);
+}
+
+size_t ModelFile::trajectoryPoints() const
+{
+    return this->header->trajectoryPoints;
+}
+
+bool ModelFile::hasMesh() const
+{
+    return this->header->vertices != 0;
+}
+
+const glm::vec3* ModelFile::vertices() const
+{
+    return (const glm::vec3*) this->at(this->header->verticesOffset);
+}
+
+size_t ModelFile::vertexCount() const
+{
+    return this->header->vertices;
+}
+
+IndexBuffer::Width ModelFile::getIndexWidth() const
+{
+    return (IndexBuffer::Width) this->header->indexWidth;
+}
+
+IndexBuffer::Topology ModelFile::getTopology() const
+{
+    return (IndexBuffer::Topology) this->header->topology;
+}
+
+const void* ModelFile::indices() const
+{
+    return this->at(this->header->indicesOffset);
+}
+
+size_t ModelFile::indexCount() const
+{
+    return this->header->indices;
+}
+
+const ModelFileMeshlet* ModelFile::meshlets() const
+{
+    return (const ModelFileMeshlet*) this->at(this->header->meshletsOffset);
+}
+
+size_t ModelFile::meshletCount() const
+{
+    return this->header->meshlets;
+}
+
+bool ModelFile::loadMesh(SweepMesh &mesh) const
+{
+    if (!this->hasMesh())
+        return false;
+
+    mesh.profile.clear();
+    mesh.trajectory.clear();
+    mesh.vertices.assign(this->vertices(),
+                         this->vertices() + this->vertexCount());
+    mesh.sweeps = this->header->sweeps;
+
+    IndexBuffer &indices = mesh.indices;
+    indices.clear();
+    indices.setTopology(this->getTopology());
+    indices.resize(this->getIndexWidth(), this->indexCount());
+
+    if (this->getIndexWidth() == IndexBuffer::Width::U16)
+        memcpy(indices.u16(), this->indices(), indices.bytes());
+    else
+        memcpy(indices.u32(), this->indices(), indices.bytes());
+
+    for (size_t m = 0; m < this->meshletCount(); m++)
+    {
+        const ModelFileMeshlet &stored = this->meshlets()[m];
+        Meshlet meshlet = {(uint32_t) stored.baseVertex,
+                           (size_t) stored.firstIndex,
+                           (size_t) stored.indexCount};
+        indices.meshlets.push_back(meshlet);
+    }
+    return true;
+}
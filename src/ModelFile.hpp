@@ -0,0 +1,115 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Binary DataModel container, memory mapped and used in place
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "DataModel.hpp"
+#include "IndexBuffer.hpp"
+#include "Sweeper.hpp"
+
+/*
+ * Layout, little endian, every array 64 bytes aligned:
+ *
+ *  header | profile vec3[] | trajectory vec3[] |
+ *  vertices vec3[] | indices u16[] or u32[] | meshlets[]
+ *
+ * Only the control points are required, the swept surface is
+ * stored by the converter on demand. An array is absent when
+ * its count is 0.
+*/
+struct ModelFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sweepType;
+    uint32_t spans;
+    // IndexBuffer::Width, 0 without indices
+    uint32_t indexWidth;
+    uint32_t topology;
+    uint32_t sweeps;
+    uint64_t profilePoints;
+    uint64_t profileOffset;
+    uint64_t trajectoryPoints;
+    uint64_t trajectoryOffset;
+    uint64_t vertices;
+    uint64_t verticesOffset;
+    uint64_t indices;
+    uint64_t indicesOffset;
+    uint64_t meshlets;
+    uint64_t meshletsOffset;
+};
+
+// Meshlet with fixed width fields
+struct ModelFileMeshlet
+{
+    uint64_t baseVertex;
+    uint64_t firstIndex;
+    uint64_t indexCount;
+};
+
+class ModelFile
+{
+    public:
+        static const uint32_t version = 1;
+        static const size_t alignment = 64;
+
+        ModelFile();
+        ~ModelFile();
+
+        // maps the whole file read only, false if not a valid model
+        bool open(const std::string &filename);
+        void close();
+        bool isOpen() const;
+
+        // checks the magic only
+        static bool isModelFile(const std::string &filename);
+
+        // mesh: also stores its vertices and indices unless NULL
+        static bool save(const std::string &filename,
+                         const DataModel &dataModel,
+                         const SweepMesh *mesh = NULL);
+
+        DataModel::SweepType getSweepType() const;
+        size_t getSpans() const;
+        size_t bytes() const;
+
+        // pointers into the mapping, valid until close()
+        const glm::vec3* profile() const;
+        size_t profilePoints() const;
+        const glm::vec3* trajectory() const;
+        size_t trajectoryPoints() const;
+
+        bool hasMesh() const;
+        const glm::vec3* vertices() const;
+        size_t vertexCount() const;
+        IndexBuffer::Width getIndexWidth() const;
+        IndexBuffer::Topology getTopology() const;
+        const void* indices() const;
+        size_t indexCount() const;
+        const ModelFileMeshlet* meshlets() const;
+        size_t meshletCount() const;
+
+        // copies the stored surface, false if there is none
+        bool loadMesh(SweepMesh &mesh) const;
+
+    private:
+        bool validate() const;
+        // every meshlet within the indices, every index within the vertices
+        bool validateMeshlets() const;
+        const void* at(const uint64_t offset) const;
+
+        int fd;
+        const uint8_t *base;
+        size_t size;
+        const ModelFileHeader *header;
+};
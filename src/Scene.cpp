@@ -0,0 +1,202 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "Scene.hpp"
+
+#include "FrameUniforms.hpp"
+
+// texture unit of the transforms
+static const GLint transformsUnit = 0;
+
+Scene::Scene() :
+    vbo(GL_ARRAY_BUFFER),
+    ebo(GL_ELEMENT_ARRAY_BUFFER),
+    modelIndices(GL_ARRAY_BUFFER),
+    transforms(GL_TEXTURE_BUFFER),
+    commands(GL_DRAW_INDIRECT_BUFFER)
+{
+    this->shader = Shader::acquire(
+        "src/shaders/scene.vs",
+        "src/shaders/default.fs");
+
+    this->shader->bindUniformBlock(FrameUniforms::blockName(),
+                                   FrameUniforms::binding);
+
+    this->shader->use();
+    glUniform1i(this->shader->getUniformLocation("models"), transformsUnit);
+    glUniform1i(this->shader->getUniformLocation("colorize"), 1);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &this->vaoId);
+    glGenTextures(1, &this->transformsTexture);
+
+    // the base instance of the commands picks the model
+    this->indirect = GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance;
+    this->initVertexArray();
+}
+
+Scene::~Scene()
+{
+    glDeleteTextures(1, &this->transformsTexture);
+    glDeleteVertexArrays(1, &this->vaoId);
+    Shader::release(this->shader);
+}
+
+void Scene::initVertexArray()
+{
+    glBindVertexArray(this->vaoId);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->vbo.getId());
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(glm::vec3), NULL);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->modelIndices.getId());
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(uint32_t), NULL);
+    glVertexAttribDivisor(1, this->indirect ? 1 : 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo.getId());
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+size_t Scene::add(const SweepMesh &mesh, const glm::mat4 &model)
+{
+    std::vector<uint32_t> triangles;
+    size_t index = this->models.size();
+
+    mesh.indices.triangles(triangles);
+
+    DrawElementsCommand command;
+    command.count = triangles.size();
+    command.instanceCount = 1;
+    command.firstIndex = this->indices.size();
+    command.baseVertex = this->vertices.size();
+    command.baseInstance = index;
+    this->drawCommands.push_back(command);
+
+    this->counts.push_back(command.count);
+    this->offsets.push_back((const void*) (sizeof(uint32_t) *
+                                           command.firstIndex));
+    this->baseVertices.push_back(command.baseVertex);
+
+    this->vertices.insert(this->vertices.end(),
+                          mesh.vertices.begin(), mesh.vertices.end());
+    this->indices.insert(this->indices.end(),
+                         triangles.begin(), triangles.end());
+    this->vertexModels.insert(this->vertexModels.end(),
+                              mesh.vertices.size(), index);
+    this->instanceModels.push_back(index);
+    this->models.push_back(model);
+    this->triangles += triangles.size() / 3;
+
+    return index;
+}
+
+void Scene::setModel(const size_t index, const glm::mat4 &model)
+{
+    this->models[index] = model;
+    this->transforms.update(&this->models[0], sizeof(glm::mat4) * index,
+                            sizeof(glm::mat4));
+}
+
+size_t Scene::size() const
+{
+    return this->models.size();
+}
+
+bool Scene::isIndirect() const
+{
+    return this->indirect;
+}
+
+void Scene::setIndirect(const bool indirect)
+{
+    if (indirect && !(GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance))
+        return;
+
+    this->indirect = indirect;
+    this->modelIndices.invalidate();
+    this->initVertexArray();
+}
+
+void Scene::upload()
+{
+    if (this->models.empty())
+        return;
+
+    this->vbo.upload(&this->vertices[0],
+                     sizeof(glm::vec3) * this->vertices.size());
+
+    const std::vector<uint32_t> &ids =
+        this->indirect ? this->instanceModels : this->vertexModels;
+    this->modelIndices.upload(&ids[0], sizeof(uint32_t) * ids.size());
+
+    // the ebo binding belongs to the vao
+    glBindVertexArray(this->vaoId);
+        this->ebo.upload(&this->indices[0],
+                         sizeof(uint32_t) * this->indices.size());
+    glBindVertexArray(0);
+
+    size_t capacity = this->transforms.capacity();
+    this->transforms.upload(&this->models[0],
+                            sizeof(glm::mat4) * this->models.size());
+    // the texture follows its buffer whenever the storage is reallocated
+    if (capacity != this->transforms.capacity())
+    {
+        glBindTexture(GL_TEXTURE_BUFFER, this->transformsTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, this->transforms.getId());
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    if (this->indirect)
+        this->commands.upload(&this->drawCommands[0],
+                              sizeof(DrawElementsCommand) *
+                              this->drawCommands.size());
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void Scene::draw(const GLenum renderMode, DrawStats &stats)
+{
+    stats = DrawStats();
+
+    if (this->models.empty())
+        return;
+
+    GLenum mode = (renderMode == GL_POINTS) ? GL_POINTS : GL_TRIANGLES;
+
+    this->shader->use();
+
+    glActiveTexture(GL_TEXTURE0 + transformsUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, this->transformsTexture);
+
+    glBindVertexArray(this->vaoId);
+
+    if (this->indirect)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commands.getId());
+        glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, NULL,
+                                    this->drawCommands.size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else
+    {
+        glMultiDrawElementsBaseVertex(mode, &this->counts[0],
+                                      GL_UNSIGNED_INT, &this->offsets[0],
+                                      this->counts.size(),
+                                      &this->baseVertices[0]);
+    }
+
+    glBindVertexArray(0);
+
+    stats.drawCalls = 1;
+    stats.vertices = this->vertices.size();
+    if (mode != GL_POINTS)
+        stats.triangles = this->triangles;
+}
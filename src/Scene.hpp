@@ -0,0 +1,81 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Many swept models in shared buffers, drawn by a single call
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "Shader.hpp"
+#include "GpuBuffer.hpp"
+#include "Sweeper.hpp"
+#include "FrameProfiler.hpp"
+
+// as read by glMultiDrawElementsIndirect
+struct DrawElementsCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    // the index of the model, see Scene
+    GLuint baseInstance;
+};
+
+/*
+ * Every model is packed into one vertex and one 32 bits index buffer
+ * as a triangle list, its transform being 4 texels of a texture buffer
+ * fetched by model index: the vertex attribute 1, per instance with the
+ * base instance of its indirect command (GL 4.3), per vertex otherwise,
+ * drawn with glMultiDrawElementsBaseVertex (GL 3.3). Either way, one
+ * call draws the whole scene.
+*/
+class Scene
+{
+    public:
+        Scene();
+        ~Scene();
+
+        // a copy of the surface, returns its model index
+        size_t add(const SweepMesh &mesh, const glm::mat4 &model);
+        void setModel(const size_t index, const glm::mat4 &model);
+        size_t size() const;
+
+        // supported by the context unless turned off
+        bool isIndirect() const;
+        void setIndirect(const bool indirect);
+
+        // what was added or changed since the last call
+        void upload();
+        void draw(const GLenum renderMode, DrawStats &stats);
+
+    private:
+        void initVertexArray();
+
+        Shader *shader;
+        GLuint vaoId;
+        GpuBuffer vbo, ebo, modelIndices, transforms, commands;
+        GLuint transformsTexture;
+        bool indirect;
+
+        std::vector<glm::vec3> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<glm::mat4> models;
+        std::vector<DrawElementsCommand> drawCommands;
+        // attribute 1: 0 to n - 1 per instance, or of every vertex
+        std::vector<uint32_t> instanceModels;
+        std::vector<uint32_t> vertexModels;
+        // glMultiDrawElementsBaseVertex arguments
+        std::vector<GLsizei> counts;
+        std::vector<const void*> offsets;
+        std::vector<GLint> baseVertices;
+        size_t triangles = 0;
+};
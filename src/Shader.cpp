@@ -6,70 +6,240 @@
 
 #include <Shader.hpp>
 
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+struct EmbeddedSource
+{
+    const char *path;
+    const char *code;
+};
+
+// generated by make, a {path, code} line per file of src/shaders
+static const EmbeddedSource embeddedSources[] = {
+#include "ShaderSources.inc"
+    {NULL, NULL}
+};
+
+// vertex and fragment, or the four of the tessellated pipeline
+static const GLenum stageTypes[2][4] = {
+    {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER},
+    {GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER,
+     GL_TESS_EVALUATION_SHADER, GL_FRAGMENT_SHADER}
+};
+static const char *stageNames[2][4] = {
+    {"VERTEX", "FRAGMENT"},
+    {"VERTEX", "TESS_CONTROL", "TESS_EVALUATION", "FRAGMENT"}
+};
+
+static std::map<std::string, Shader*> sharedPrograms;
+static std::string cacheDirectory;
+static size_t compiledPrograms = 0;
+static size_t cachedPrograms = 0;
+
+// 64 bits FNV-1a
+static uint64_t hash(const std::string &bytes, uint64_t h)
+{
+    for (unsigned char c: bytes)
+        h = (h ^ c) * 1099511628211ULL;
+    return h;
+}
+
 Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 {
-    // 1. Retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+    const GLchar* paths[] = {vertexPath, fragmentPath};
+    this->build(paths, 2);
+}
+
+Shader::Shader(const GLchar* vertexPath,
+               const GLchar* tessControlPath,
+               const GLchar* tessEvaluationPath,
+               const GLchar* fragmentPath)
+{
+    const GLchar* paths[] = {
+        vertexPath, tessControlPath, tessEvaluationPath, fragmentPath
+    };
+    this->build(paths, 4);
+}
+
+Shader* Shader::acquire(const GLchar* vertexPath,
+                        const GLchar* fragmentPath)
+{
+    const GLchar* paths[] = {vertexPath, fragmentPath};
+    return Shader::acquire(paths, 2);
+}
+
+Shader* Shader::acquire(const GLchar* vertexPath,
+                        const GLchar* tessControlPath,
+                        const GLchar* tessEvaluationPath,
+                        const GLchar* fragmentPath)
+{
+    const GLchar* paths[] = {
+        vertexPath, tessControlPath, tessEvaluationPath, fragmentPath
+    };
+    return Shader::acquire(paths, 4);
+}
+
+Shader* Shader::acquire(const GLchar* const *paths, const size_t count)
+{
+    std::string key;
+    for (size_t i = 0; i < count; i++)
+        key += std::string(paths[i]) + "\n";
+
+    Shader *&shader = sharedPrograms[key];
+    if (shader == NULL)
+    {
+        if (count == 2)
+            shader = new Shader(paths[0], paths[1]);
+        else
+            shader = new Shader(paths[0], paths[1], paths[2], paths[3]);
+        shader->key = key;
+    }
+    shader->references++;
+    return shader;
+}
+
+void Shader::release(Shader *shader)
+{
+    if (shader == NULL || --shader->references > 0)
+        return;
+
+    sharedPrograms.erase(shader->key);
+    glDeleteProgram(shader->ProgramId);
+    delete shader;
+}
+
+void Shader::setCacheDirectory(const std::string &directory)
+{
+    cacheDirectory = directory;
+}
+
+void Shader::getBuildCounts(size_t &compiled, size_t &cached)
+{
+    compiled = compiledPrograms;
+    cached = cachedPrograms;
+}
+
+bool Shader::readSource(const GLchar* path, std::string &code)
+{
+    for (const EmbeddedSource *source = embeddedSources;
+         source->path != NULL; source++)
+    {
+        if (std::string(source->path) == path)
+        {
+            code = source->code;
+            return true;
+        }
+    }
+
+    // 1. Retrieve the source code from filePath
+    std::ifstream shaderFile;
     // ensures ifstream objects can throw exceptions:
-    vShaderFile.exceptions (std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::badbit);
+    shaderFile.exceptions (std::ifstream::badbit);
     try
     {
-        // Open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // Read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
+        // Open file
+        shaderFile.open(path);
+        std::stringstream shaderStream;
+        // Read file's buffer contents into stream
+        shaderStream << shaderFile.rdbuf();
+        // close file handler
+        shaderFile.close();
         // Convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        code = shaderStream.str();
     }
     catch (std::ifstream::failure e)
     {
         fprintf(stderr, "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ");
+        return false;
     }
-    const GLchar* vShaderCode = vertexCode.c_str();
-    const GLchar * fShaderCode = fragmentCode.c_str();
-    // 2. Compile shaders
-    GLuint vertex, fragment;
-    GLint success;
-    GLchar infoLog[512];
-    // Vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    // Print compile errors if any
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success)
+    return true;
+}
+
+void Shader::build(const GLchar* const *paths, const size_t count)
+{
+    size_t pipeline = (count == 4) ? 1 : 0;
+    std::vector<std::string> sources(count);
+    std::string file;
+
+    for (size_t i = 0; i < count; i++)
+        Shader::readSource(paths[i], sources[i]);
+
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    // a binary is only valid for the driver that saved it
+    if (!cacheDirectory.empty() && formats > 0)
     {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        fprintf(stderr, "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n%s",
-                infoLog);
+        uint64_t h = 14695981039346656037ULL;
+        const GLenum strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+        for (GLenum name: strings)
+        {
+            const GLubyte *string = glGetString(name);
+            if (string)
+                h = hash((const char*) string, h);
+        }
+        for (const auto &source: sources)
+            h = hash(source, hash(std::to_string(source.size()), h));
+
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) h);
+        file = cacheDirectory + "/" + name;
+
+        if (this->loadBinary(file))
+        {
+            cachedPrograms++;
+            this->cacheUniformLocations();
+            return;
+        }
     }
-    // Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
+
+    std::vector<GLuint> stages(count);
+    for (size_t i = 0; i < count; i++)
+        stages[i] = this->compile(stageTypes[pipeline][i],
+                                  stageNames[pipeline][i], sources[i]);
+    this->link(&stages[0], count);
+    compiledPrograms++;
+
+    if (!file.empty())
+        this->saveBinary(file);
+}
+
+GLuint Shader::compile(const GLenum type, const char *name,
+                       const std::string &code)
+{
+    const GLchar* shaderCode = code.c_str();
+    // 2. Compile shader
+    GLint success;
+    GLchar infoLog[512];
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &shaderCode, NULL);
+    glCompileShader(shader);
     // Print compile errors if any
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success)
     {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        fprintf(stderr, "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n%s",
-                infoLog);
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        fprintf(stderr, "ERROR::SHADER::%s::COMPILATION_FAILED\n%s",
+                name, infoLog);
     }
+    return shader;
+}
+
+void Shader::link(const GLuint *stages, const size_t count)
+{
+    GLint success;
+    GLchar infoLog[512];
     // Shader Program
     this->ProgramId = glCreateProgram();
-    glAttachShader(this->ProgramId, vertex);
-    glAttachShader(this->ProgramId, fragment);
+    if (GLEW_ARB_get_program_binary && !cacheDirectory.empty())
+        glProgramParameteri(this->ProgramId,
+                            GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    for (size_t i = 0; i < count; i++)
+        glAttachShader(this->ProgramId, stages[i]);
     glLinkProgram(this->ProgramId);
     // Print linking errors if any
     glGetProgramiv(this->ProgramId, GL_LINK_STATUS, &success);
@@ -79,9 +249,98 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
         fprintf(stderr, "ERROR::SHADER::PROGRAM::LINKING_FAILED\n%s", infoLog);
     }
     // Delete the shaders as they're linked into our program now and no longer necessery
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    for (size_t i = 0; i < count; i++)
+        glDeleteShader(stages[i]);
+
+    this->cacheUniformLocations();
+}
+
+bool Shader::loadBinary(const std::string &file)
+{
+    std::ifstream in(file, std::ios::binary);
+    GLenum format = 0;
+    GLint success = 0;
+
+    if (!in.read((char*) &format, sizeof(format)))
+        return false;
+
+    std::vector<char> binary((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+    if (binary.empty())
+        return false;
+
+    this->ProgramId = glCreateProgram();
+    glProgramBinary(this->ProgramId, format, &binary[0], binary.size());
+
+    // rejected after a driver update the version string did not catch
+    glGetProgramiv(this->ProgramId, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(this->ProgramId);
+        return false;
+    }
+    return true;
+}
+
+void Shader::saveBinary(const std::string &file)
+{
+    GLint length = 0;
+    GLenum format = 0;
+
+    glGetProgramiv(this->ProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    glGetProgramBinary(this->ProgramId, length, NULL, &format, &binary[0]);
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out.write((const char*) &format, sizeof(format));
+    out.write(&binary[0], binary.size());
+    if (!out)
+        fprintf(stderr, "Cannot write the program binary %s\n",
+                file.c_str());
+}
+
+void Shader::cacheUniformLocations()
+{
+    GLint count = 0;
+    GLchar name[256];
+
+    glGetProgramiv(this->ProgramId, GL_ACTIVE_UNIFORMS, &count);
+
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type;
+
+        glGetActiveUniform(this->ProgramId, i, sizeof(name), &length,
+                           &size, &type, name);
+
+        // block members have no location of their own
+        GLint location = glGetUniformLocation(this->ProgramId, name);
+        if (location >= 0)
+            this->uniformLocations[std::string(name, length)] = location;
+    }
+}
+
+GLint Shader::getUniformLocation(const std::string &name) const
+{
+    auto found = this->uniformLocations.find(name);
+    if (found == this->uniformLocations.end())
+        return -1;
+    return found->second;
+}
+
+bool Shader::bindUniformBlock(const GLchar *name, const GLuint binding)
+{
+    GLuint index = glGetUniformBlockIndex(this->ProgramId, name);
+    if (index == GL_INVALID_INDEX)
+        return false;
 
+    glUniformBlockBinding(this->ProgramId, index, binding);
+    return true;
 }
 
 // Uses the current shader
@@ -9,18 +9,70 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
 
 #include <stdio.h>
   
 #include <GL/glew.h>
 
+/*
+ * The stage sources come from the copies embedded at build time
+ * (ShaderSources.inc, generated by make from src/shaders), the files
+ * being read only if missing from it. Linked programs are saved with
+ * glGetProgramBinary into the cache directory, if any, under a hash of
+ * the driver (vendor, renderer, version) and of the sources, then
+ * loaded back by the next runs instead of being compiled.
+*/
 class Shader
 {
     public:
         GLuint ProgramId;
-        
+
+        // one program per set of stages, shared until its last release
+        static Shader* acquire(const GLchar* vertexPath,
+                               const GLchar* fragmentPath);
+        static Shader* acquire(const GLchar* vertexPath,
+                               const GLchar* tessControlPath,
+                               const GLchar* tessEvaluationPath,
+                               const GLchar* fragmentPath);
+        static void release(Shader *shader);
+
+        // none by default, the binaries are neither loaded nor saved
+        static void setCacheDirectory(const std::string &directory);
+        // programs built so far, from the sources or from the cache
+        static void getBuildCounts(size_t &compiled, size_t &cached);
+
+
         Shader(const GLchar* vertexPath,
                const GLchar* fragmentPath);
+        // GL 4.0, drawn as GL_PATCHES
+        Shader(const GLchar* vertexPath,
+               const GLchar* tessControlPath,
+               const GLchar* tessEvaluationPath,
+               const GLchar* fragmentPath);
         
         void use();
+
+        // resolved once after linking, -1 if not an active uniform
+        GLint getUniformLocation(const std::string &name) const;
+        // false if the program has no such block
+        bool bindUniformBlock(const GLchar *name, const GLuint binding);
+
+    private:
+        static Shader* acquire(const GLchar* const *paths,
+                               const size_t count);
+        static bool readSource(const GLchar* path, std::string &code);
+
+        void build(const GLchar* const *paths, const size_t count);
+        GLuint compile(const GLenum type, const char *name,
+                       const std::string &code);
+        void link(const GLuint *stages, const size_t count);
+        bool loadBinary(const std::string &file);
+        void saveBinary(const std::string &file);
+        void cacheUniformLocations();
+
+        std::unordered_map<std::string, GLint> uniformLocations;
+        // the key in the shared programs, acquired ones only
+        std::string key;
+        size_t references = 0;
 };
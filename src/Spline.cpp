@@ -5,24 +5,108 @@
 
 #include <Spline.hpp>
 
-Spline::Spline()
+#include <algorithm>
+
+// screen pixels per sample of the full surface before a coarser level
+static const float lodSamplePixels = 2.0f;
+// in levels, around each switching point, against popping
+static const float lodHysteresis = 0.25f;
+
+// positions only, or interleaved with the normals in attribute 1
+static void setVertexLayout(const GLuint vaoId, const GLuint vboId,
+                            const bool normals)
+{
+    GLsizei stride = (normals ? 2 : 1) * sizeof(glm::vec3);
+
+    glBindVertexArray(vaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, vboId);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, NULL);
+    if (normals)
+    {
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                              (GLvoid*) sizeof(glm::vec3));
+    }
+    else
+    {
+        glDisableVertexAttribArray(1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+static void interleave(const std::vector<glm::vec3> &vertices,
+                       const std::vector<glm::vec3> &normals,
+                       std::vector<glm::vec3> &interleaved)
+{
+    interleaved.resize(2 * vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        interleaved[2 * i] = vertices[i];
+        interleaved[2 * i + 1] = normals[i];
+    }
+}
+
+SplineLod::SplineLod() :
+    vbo(GL_ARRAY_BUFFER),
+    ebo(GL_ELEMENT_ARRAY_BUFFER)
+{
+    glGenVertexArrays(1, &this->vaoId);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->vbo.getId());
+    glBindVertexArray(this->vaoId);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo.getId());
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(glm::vec3), NULL);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+SplineLod::~SplineLod()
+{
+    glDeleteVertexArrays(1, &this->vaoId);
+}
+
+Spline::Spline() :
+    vbo(GL_ARRAY_BUFFER),
+    ebo(GL_ELEMENT_ARRAY_BUFFER)
 {
     this->dataModel = new DataModel();
     this->splinesIndices.clear();
 
-    this->shader = new Shader(
+    this->pool = new ThreadPool();
+    this->sweeper.setThreadPool(this->pool);
+    this->sweeper.setArena(&this->arena);
+
+    this->shader = Shader::acquire(
         "src/shaders/default.vs",
         "src/shaders/default.fs");
 
+    this->modelLoc = this->shader->getUniformLocation("model");
+    this->colorizeLoc = this->shader->getUniformLocation("colorize");
+    this->shader->bindUniformBlock(FrameUniforms::blockName(),
+                                   FrameUniforms::binding);
+
     this->initBuffers();
 }
 
 Spline::~Spline()
 {
     delete this->dataModel;
-    glDeleteBuffers(1, &this->eboId);
+    delete this->pool;
+    delete this->instancedSweep;
+    delete this->tessellatedSweep;
+    delete this->streamingCurve;
+    Shader::release(this->shader);
+    Shader::release(this->litShader);
+    for (SplineLod *lod: this->lods)
+        delete lod;
     glDeleteVertexArrays(1, &this->vaoId);
-    glDeleteBuffers(1, &this->vboId);
 }
 
 bool Spline::initData(const std::string fileSuffix,
@@ -63,25 +147,15 @@ void Spline::setSweepType(DataModel::SweepType sweepType)
 
 void Spline::initBuffers()
 {
-    glGenBuffers(1, &this->vboId);
     glGenVertexArrays(1, &this->vaoId);
-    glGenBuffers(1, &this->eboId);
 
-    glBindBuffer(GL_ARRAY_BUFFER, this->vboId);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(glm::vec3) *
-                    this->splines.size(),
-                 &this->splines[0], GL_STATIC_DRAW);
+    // storage is allocated on the first upload
+    glBindBuffer(GL_ARRAY_BUFFER, this->vbo.getId());
 
     // has to be before ebo bind
     glBindVertexArray(this->vaoId);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->eboId);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 sizeof(this->splinesIndices) *
-                    this->splinesIndices.size(),
-                 &this->splinesIndices[0],
-                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo.getId());
 
     // enable vao -> vbo pointing
     glEnableVertexAttribArray(0);
@@ -114,32 +188,85 @@ Spline::DrawStage Spline::getDrawStage() const
 void Spline::setDrawStage(const Spline::DrawStage drawStage)
 {
     this->drawStage = drawStage;
+    this->uniformsDirty = true;
 }
 
-void Spline::render(const Window* window, const Camera* camera,
-                  const glm::mat4 view, const glm::mat4 projection)
+void Spline::render(const Window* window, const Camera* camera)
 {
     this->shader->use();
 
-    // locate in shaders gpu
-    GLint modelLoc = glGetUniformLocation(this->shader->ProgramId, "model");
-    GLint viewLoc = glGetUniformLocation(this->shader->ProgramId, "view");
-    GLint projLoc = glGetUniformLocation(this->shader->ProgramId, "projection");
+    if (this->streamingCurve)
+    {
+        if (this->uniformsDirty)
+        {
+            glUniformMatrix4fv(this->modelLoc, 1, GL_FALSE,
+                               glm::value_ptr(this->model));
+            glUniform1i(this->colorizeLoc, 1);
+            this->uniformsDirty = false;
+        }
+        // what was appended since the last frame
+        this->streamingCurve->upload();
+        this->streamingCurve->draw(this->renderMode, this->drawStats);
+        return;
+    }
+
+    if (this->tessellating &&
+        this->getDrawStage() == Spline::DrawStage::THREE)
+    {
+        if (this->uniformsDirty)
+            this->tessellatedSweep->setModel(this->model);
+        this->uniformsDirty = false;
+
+        // the camera only changes the Frame block, levels follow it
+        this->tessellatedSweep->draw(
+            this->renderMode,
+            glm::vec2(window->width(), window->height()),
+            this->drawStats);
+        return;
+    }
 
-    // send to shaders on gpu
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(this->model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    if (this->instancedSweep &&
+        this->getDrawStage() == Spline::DrawStage::THREE)
+    {
+        if (this->uniformsDirty)
+            this->instancedSweep->setModel(this->model);
+        this->uniformsDirty = false;
 
-    if (this->getDrawStage() == Spline::DrawStage::THREE)
+        this->instancedSweep->draw(this->renderMode, this->drawStats);
+        return;
+    }
+
+    // swept with its normals, a stage change away from the curves
+    bool lit = (this->getDrawStage() == Spline::DrawStage::THREE &&
+                !this->splinesNormals.empty());
+    if (lit)
+        this->litShader->use();
+
+    // program state, kept between frames
+    if (this->uniformsDirty)
     {
-        GLint colorizeLoc = glGetUniformLocation(
-            this->shader->ProgramId, "colorize");
-        glUniform1i(colorizeLoc, 1);
+        if (lit)
+        {
+            glUniformMatrix4fv(this->litModelLoc, 1, GL_FALSE,
+                               glm::value_ptr(this->model));
+        }
+        else
+        {
+            glUniformMatrix4fv(this->modelLoc, 1, GL_FALSE,
+                               glm::value_ptr(this->model));
+            glUniform1i(this->colorizeLoc,
+                        this->getDrawStage() == Spline::DrawStage::THREE);
+        }
+        this->uniformsDirty = false;
     }
     this->draw();
 }
 
+const DrawStats& Spline::getDrawStats() const
+{
+    return this->drawStats;
+}
+
 std::vector<glm::vec3>* Spline::getDataVertices()
 {
     std::vector<glm::vec3> *vertices;
@@ -181,25 +308,68 @@ std::vector<glm::vec3>* Spline::getDrawVertices()
 
 void Spline::draw()
 {
+    this->drawStats = DrawStats();
+
     // connect to vao & draw vertices
     glBindVertexArray(this->vaoId);
         switch (this->drawStage)
         {
             case (Spline::DrawStage::ONE):
-                glDrawArrays(this->renderMode, 0,
-                             this->getDrawVertices()->size());
-                break;
-
             case (Spline::DrawStage::TWO):
                 glDrawArrays(this->renderMode, 0,
                              this->getDrawVertices()->size());
+                this->drawStats.drawCalls = 1;
+                this->drawStats.vertices = this->getDrawVertices()->size();
                 break;
 
             case (Spline::DrawStage::THREE):
-                glDrawElements(renderMode,
-                               this->splinesIndices.size(),
-                               GL_UNSIGNED_SHORT, 0);
+            {
+                const IndexBuffer *indices = &this->splinesIndices;
+                size_t vertices = this->splines.size();
+                size_t triangles = this->splinesTriangles;
+
+                if (this->lod > 0)
+                {
+                    const SplineLod *lod = this->lods[this->lod - 1];
+                    glBindVertexArray(lod->vaoId);
+                    indices = &lod->indices;
+                    vertices = lod->vertices.size();
+                    triangles = lod->triangles;
+                }
+
+                GLenum mode = this->renderMode;
+                GLenum type = GL_UNSIGNED_INT;
+                if (indices->getWidth() == IndexBuffer::Width::U16)
+                    type = GL_UNSIGNED_SHORT;
+
+                bool strips = (indices->getTopology() ==
+                               IndexBuffer::Topology::TriangleStrip);
+                if (strips)
+                {
+                    // compared to the stored index, before base vertex
+                    glEnable(GL_PRIMITIVE_RESTART);
+                    glPrimitiveRestartIndex(indices->restartIndex());
+                    if (mode == GL_TRIANGLES)
+                        mode = GL_TRIANGLE_STRIP;
+                }
+
+                for (const auto &meshlet: indices->meshlets)
+                {
+                    glDrawElementsBaseVertex(
+                        mode, meshlet.indexCount, type,
+                        (GLvoid*) (meshlet.firstIndex *
+                                   indices->getWidth()),
+                        meshlet.baseVertex);
+                }
+                this->drawStats.drawCalls = indices->meshlets.size();
+                this->drawStats.vertices = vertices;
+                if (mode != GL_POINTS)
+                    this->drawStats.triangles = triangles;
+
+                if (strips)
+                    glDisable(GL_PRIMITIVE_RESTART);
                 break;
+            }
         }
     // disonnect vao by binding to default
     glBindVertexArray(0);
@@ -217,36 +387,407 @@ void Spline::addDrawVertex(const glm::vec3 vertex)
 
 void Spline::uploadVertices()
 {
-    // vertices
-    // connect
-    glBindBuffer(GL_ARRAY_BUFFER, this->vboId);
+    const std::vector<glm::vec3> *vertices = this->getDrawVertices();
+    bool normals = (this->getDrawStage() == Spline::DrawStage::THREE &&
+                    !this->splinesNormals.empty());
 
-        if (this->getDrawVertices()->size() == 0)
-            glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-        else
-            glBufferData(GL_ARRAY_BUFFER,
-                     sizeof(glm::vec3) * this->getDrawVertices()->size(),
-                     &this->getDrawVertices()->at(0), GL_STATIC_DRAW);
+    if (normals)
+    {
+        interleave(this->splines, this->splinesNormals,
+                   this->splinesInterleaved);
+        vertices = &this->splinesInterleaved;
+    }
+
+    // vertices, appended ones only while the same curve is edited
+    if (vertices != this->uploadedVertices)
+    {
+        this->vbo.invalidate();
+        this->uploadedVertices = vertices;
+        setVertexLayout(this->vaoId, this->vbo.getId(), normals);
+    }
+    this->vbo.upload(vertices->empty() ? NULL : &vertices->at(0),
+                     sizeof(glm::vec3) * vertices->size());
 
     // disconnect by binding to default
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // indices
+    // indices, only when regenerated
     if (this->getDrawStage() == Spline::DrawStage::THREE)
     {
-        // connect
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->eboId);
+        // the ebo binding belongs to the vao
+        glBindVertexArray(this->vaoId);
 
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                         sizeof(GLushort) * this->splinesIndices.size(),
-                        &this->splinesIndices[0], GL_STATIC_DRAW);
-        // don't disconnect to draw
+            this->ebo.upload(this->splinesIndices.data(),
+                             this->splinesIndices.bytes());
+
+        glBindVertexArray(0);
+
+        this->uploadLods();
     }
 }
 
-void Spline::setSpans(const uint16_t spans)
+// a no-op unless regenerated, like the full surface
+void Spline::uploadLods()
+{
+    for (SplineLod *lod: this->lods)
+    {
+        const std::vector<glm::vec3> *vertices = &lod->vertices;
+        if (!lod->normals.empty())
+        {
+            interleave(lod->vertices, lod->normals, lod->interleaved);
+            vertices = &lod->interleaved;
+        }
+        setVertexLayout(lod->vaoId, lod->vbo.getId(), !lod->normals.empty());
+
+        lod->vbo.upload(&(*vertices)[0],
+                        sizeof(glm::vec3) * vertices->size());
+
+        glBindVertexArray(lod->vaoId);
+            lod->ebo.upload(lod->indices.data(), lod->indices.bytes());
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+uint32_t Spline::getSpans() const
+{
+    return this->dataModel->spans;
+}
+
+void Spline::setSpans(const uint32_t spans)
 {
     this->dataModel->spans = spans;
+
+    if (this->streamingCurve || this->drawStage != Spline::DrawStage::THREE ||
+        this->getSweepType() != DataModel::SweepType::Rotational)
+        return;
+
+    if (this->tessellating)
+    {
+        this->sweep();
+        return;
+    }
+
+    if (this->instancedSweep)
+    {
+        // the profile stays, O(spans)
+        this->sweeper.sweepTransforms(this->getSweepType(), this->spline2,
+                                      spans, this->sweepTransforms);
+        this->instancedSweep->uploadTransforms(this->getSweepType(),
+                                               this->sweepTransforms);
+        return;
+    }
+    this->sweep();
+    this->genSplinesIndices();
+    this->weld();
+    this->uploadVertices();
+}
+
+bool Spline::getInstanced() const
+{
+    return this->instancedSweep != NULL;
+}
+
+void Spline::setInstanced(const bool instanced)
+{
+    if (instanced && !this->instancedSweep)
+        this->instancedSweep = new InstancedSweep();
+
+    if (!instanced)
+    {
+        delete this->instancedSweep;
+        this->instancedSweep = NULL;
+    }
+}
+
+bool Spline::getTessellated() const
+{
+    return this->tessellatedSweep != NULL;
+}
+
+void Spline::setTessellated(const bool tessellated)
+{
+    if (tessellated && !this->tessellatedSweep)
+        this->tessellatedSweep = new TessellatedSweep(
+            this->sweeper.getCurve().getTension());
+
+    if (!tessellated)
+    {
+        delete this->tessellatedSweep;
+        this->tessellatedSweep = NULL;
+        this->tessellating = false;
+    }
+}
+
+bool Spline::getLit() const
+{
+    return this->lit;
+}
+
+void Spline::setLit(const bool lit)
+{
+    this->lit = lit;
+    this->sweeper.setNormals(lit);
+
+    if (lit && !this->litShader)
+    {
+        this->litShader = Shader::acquire(
+            "src/shaders/lit.vs",
+            "src/shaders/lit.fs");
+        this->litModelLoc = this->litShader->getUniformLocation("model");
+        this->litShader->bindUniformBlock(FrameUniforms::blockName(),
+                                          FrameUniforms::binding);
+    }
+    this->uniformsDirty = true;
+}
+
+std::vector<glm::vec3>* Spline::getControlPoints(const DrawStage curve)
+{
+    if (curve == Spline::DrawStage::ONE)
+        return &this->dataModel->profileVertices;
+    if (curve == Spline::DrawStage::TWO &&
+        this->getSweepType() == DataModel::SweepType::Translational)
+        return &this->dataModel->trajectoryVertices;
+    return NULL;
+}
+
+std::vector<glm::vec3>* Spline::getSamples(const DrawStage curve)
+{
+    return (curve == Spline::DrawStage::ONE) ? &this->spline1 :
+                                               &this->spline2;
+}
+
+bool Spline::moveControlPoint(const DrawStage curve, const size_t i,
+                              const glm::vec3 &point)
+{
+    std::vector<glm::vec3> *points = this->getControlPoints(curve);
+
+    if (this->drawStage != Spline::DrawStage::THREE || !points ||
+        i >= points->size())
+        return false;
+
+    this->regenerate(curve, this->sweeper.moveControlPoint(
+        *points, *this->getSamples(curve), i, point));
+    return true;
+}
+
+bool Spline::insertControlPoint(const DrawStage curve, const size_t i,
+                                const glm::vec3 &point)
+{
+    std::vector<glm::vec3> *points = this->getControlPoints(curve);
+
+    if (this->drawStage != Spline::DrawStage::THREE || !points ||
+        i > points->size())
+        return false;
+
+    this->regenerate(curve, this->sweeper.insertControlPoint(
+        *points, *this->getSamples(curve), i, point));
+    return true;
+}
+
+bool Spline::deleteControlPoint(const DrawStage curve, const size_t i)
+{
+    std::vector<glm::vec3> *points = this->getControlPoints(curve);
+
+    if (this->drawStage != Spline::DrawStage::THREE || !points ||
+        i >= points->size() || points->size() <= 4)
+        return false;
+
+    this->regenerate(curve, this->sweeper.eraseControlPoint(
+        *points, *this->getSamples(curve), i));
+    return true;
+}
+
+glm::vec3 Spline::getControlPointPosition(const DrawStage curve,
+                                          const size_t i) const
+{
+    const std::vector<glm::vec3> &profile = this->dataModel->profileVertices;
+    const std::vector<glm::vec3> &trajectory =
+        this->dataModel->trajectoryVertices;
+
+    if (curve == Spline::DrawStage::ONE)
+        return profile[i];
+    // the offset of its profile copy, see Sweeper::sweepTransforms
+    return profile[0] + trajectory[i] - trajectory[0];
+}
+
+glm::vec3 Spline::getControlPoint(const DrawStage curve,
+                                  const size_t i) const
+{
+    return (curve == Spline::DrawStage::ONE) ?
+        this->dataModel->profileVertices[i] :
+        this->dataModel->trajectoryVertices[i];
+}
+
+bool Spline::pickControlPoint(const glm::vec2 &cursor, const glm::mat4 &view,
+                              const glm::mat4 &projection,
+                              const glm::vec2 &viewport, const float radius,
+                              DrawStage &curve, size_t &i) const
+{
+    const DrawStage curves[] = {Spline::DrawStage::ONE,
+                                Spline::DrawStage::TWO};
+    glm::mat4 transform = projection * view * this->model;
+    float nearest = radius * radius;
+    bool picked = false;
+
+    if (this->drawStage != Spline::DrawStage::THREE ||
+        this->dataModel->profileVertices.empty())
+        return false;
+
+    for (const DrawStage c: curves)
+    {
+        const std::vector<glm::vec3> *points =
+            (c == Spline::DrawStage::ONE) ? &this->dataModel->profileVertices :
+            (this->getSweepType() == DataModel::SweepType::Translational) ?
+                &this->dataModel->trajectoryVertices : NULL;
+
+        if (!points)
+            continue;
+
+        for (size_t p = (c == Spline::DrawStage::TWO); p < points->size(); p++)
+        {
+            glm::vec4 clip = transform *
+                glm::vec4(this->getControlPointPosition(c, p), 1.0f);
+            // behind the camera
+            if (clip.w <= 0)
+                continue;
+
+            glm::vec2 offset = (glm::vec2(clip.x, clip.y) / clip.w + 1.0f) *
+                               0.5f * viewport - cursor;
+            float distance = glm::dot(offset, offset);
+
+            if (distance <= nearest)
+            {
+                nearest = distance;
+                curve = c;
+                i = p;
+                picked = true;
+            }
+        }
+    }
+    return picked;
+}
+
+bool Spline::dragControlPoint(const DrawStage curve, const size_t i,
+                              const glm::vec2 &cursor, const glm::mat4 &view,
+                              const glm::mat4 &projection,
+                              const glm::vec2 &viewport)
+{
+    std::vector<glm::vec3> *points = this->getControlPoints(curve);
+
+    // the first trajectory point anchors the others
+    if (!points || i >= points->size() ||
+        (curve == Spline::DrawStage::TWO && i == 0))
+        return false;
+
+    glm::mat4 transform = projection * view * this->model;
+    glm::vec3 position = this->getControlPointPosition(curve, i);
+    glm::vec4 clip = transform * glm::vec4(position, 1.0f);
+
+    if (clip.w <= 0)
+        return false;
+
+    glm::vec2 ndc = cursor / viewport * 2.0f - 1.0f;
+    glm::vec4 moved = glm::inverse(transform) *
+                      glm::vec4(ndc.x, ndc.y, clip.z / clip.w, 1.0f);
+    glm::vec3 offset = glm::vec3(moved) / moved.w - position;
+
+    if (glm::dot(offset, offset) == 0)
+        return true;
+
+    return this->moveControlPoint(curve, i, (*points)[i] + offset);
+}
+
+void Spline::regenerate(const DrawStage curve, const SampleRange &changed)
+{
+    this->arena.reset();
+
+    // the gpu sweeps from the curves, small uploads either way
+    if (this->tessellating || this->instancedSweep)
+    {
+        if (this->tessellating)
+            this->sweep();
+        else
+            this->sweepInstanced();
+        return;
+    }
+
+    // the curve derivatives as well, along the whole surface
+    if (this->lit)
+    {
+        this->sweep();
+        this->genSplinesIndices();
+        this->weld();
+        this->uploadVertices();
+        return;
+    }
+
+    // another grid: every copy, the indices and the welded vertices
+    if (changed.resized || this->weldVertices || this->spline1.empty())
+    {
+        this->sweepSplines();
+        this->genSplinesIndices();
+        this->weld();
+        this->uploadVertices();
+        return;
+    }
+
+    size_t points = this->spline1.size();
+    size_t copies = this->splines.size() / points;
+    const glm::vec3 *vertices = &this->splines[0];
+
+    if (curve == Spline::DrawStage::ONE)
+    {
+        // the changed samples of every copy
+        this->sweeper.resweepProfile(this->getSweepType(), this->spline1,
+                                     this->spline2, this->dataModel->spans,
+                                     changed, this->splines);
+        for (size_t c = 0; c < copies; c++)
+            this->vbo.update(vertices,
+                             sizeof(glm::vec3) * (c * points + changed.begin),
+                             sizeof(glm::vec3) * (changed.end -
+                                                  changed.begin));
+    }
+    else
+    {
+        // the copies laid along the changed samples, all from t_0
+        this->sweeper.resweepTrajectory(this->spline1, this->spline2,
+                                        changed, this->splines);
+        size_t first = (changed.begin == 0) ? 0 : changed.begin + 1;
+        size_t last = (changed.begin == 0) ? copies : changed.end + 1;
+
+        this->vbo.update(vertices, sizeof(glm::vec3) * first * points,
+                         sizeof(glm::vec3) * (last - first) * points);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // same indices, the coarser surfaces follow when drawn, picked from
+    // the sphere around the edited surface
+    this->lodsDirty = true;
+    if (!this->lods.empty())
+        this->genBounds();
+}
+
+bool Spline::isStreaming() const
+{
+    return this->streamingCurve != NULL;
+}
+
+void Spline::setStreaming(const size_t capacity)
+{
+    delete this->streamingCurve;
+    this->streamingCurve = NULL;
+
+    if (capacity)
+        this->streamingCurve = new StreamingCurve(this->sweeper.getCurve(),
+                                                  capacity);
+    this->uniformsDirty = true;
+}
+
+void Spline::appendControlPoint(const glm::vec3 &point)
+{
+    if (this->streamingCurve)
+        this->streamingCurve->getStream().append(point);
 }
 
 void Spline::rotate(const glm::vec3 axesSpins)
@@ -260,83 +801,105 @@ void Spline::rotate(const glm::vec3 axesSpins)
     this->model = glm::rotate(this->model,
                               axesSpins.z * this->angleStep,
                               glm::vec3(0, 0, 1));
+    this->uniformsDirty = true;
 }
 
 void Spline::sweep()
 {
-    if (this->getSweepType() == DataModel::SweepType::Translational)
+    this->arena.reset();
+    this->vbo.invalidate();
+
+    // control points only, nothing evaluated here
+    this->tessellating = this->tessellatedSweep &&
+        this->tessellatedSweep->upload(this->getSweepType(),
+                                       this->dataModel->profileVertices,
+                                       this->dataModel->trajectoryVertices,
+                                       this->dataModel->spans);
+    if (this->tessellating)
     {
-        // regenerate normalized splines draw data {
-        this->spline1 = this->dataModel->profileVertices;
-        this->spline2 = this->dataModel->trajectoryVertices;
-        this->setDrawStage(Spline::DrawStage::ONE);
-        this->genCatmullRomSpline();
-        this->setDrawStage(Spline::DrawStage::TWO);
-        this->genCatmullRomSpline();
-        this->setDrawStage(Spline::DrawStage::THREE);
-        // } regenerate
-
-        std::vector<glm::vec3> polygon1 = this->spline1;
-        std::vector<glm::vec3> polygon2;
-        std::vector<glm::vec3> tpolygon = this->spline2;
-
         this->splines.clear();
+        this->splinesNormals.clear();
+        this->splinesIndices.clear();
+        this->splinesTriangles = 0;
+        this->setDrawStage(Spline::DrawStage::THREE);
+        return;
+    }
 
-        for (const auto& vertex: polygon1)
-            this->addDrawVertex(vertex);
-
-        // for n translation <=> n new profile curves
-        for (uint16_t i = 0; i < tpolygon.size(); i++)
-        {
-            // get translation vector from t_i+1 - t_i
-            glm::vec3 vertex(tpolygon[i+1] - tpolygon[i]);
-
-            // create new profile curve
-            polygon2 = this->translateProfileCurve(polygon1, vertex);
-
-            for (const auto& vertex: polygon1)
-                this->addDrawVertex(vertex);
+    // regenerate normalized splines draw data {
+    if (this->lit && !this->instancedSweep)
+    {
+        this->sweeper.tessellate(this->dataModel->profileVertices,
+                                 this->spline1, this->spline1Tangents);
 
-            // start at next profile curve
-            polygon1 = polygon2;
-            polygon2.clear();
-        }
+        if (this->getSweepType() == DataModel::SweepType::Translational)
+            this->sweeper.tessellate(this->dataModel->trajectoryVertices,
+                                     this->spline2, this->spline2Tangents);
     }
     else
     {
-        // regenerate normalized splines draw data {
-        this->spline1 = this->dataModel->profileVertices;
-        this->setDrawStage(Spline::DrawStage::ONE);
-        this->genCatmullRomSpline();
-        this->setDrawStage(Spline::DrawStage::THREE);
-        // } regenerate
+        this->sweeper.tessellate(this->dataModel->profileVertices,
+                                 this->spline1);
 
-        this->splines.clear();
-        for (const auto& vertex: this->spline1)
-            this->addDrawVertex(vertex); // adds to splines
+        if (this->getSweepType() == DataModel::SweepType::Translational)
+            this->sweeper.tessellate(this->dataModel->trajectoryVertices,
+                                     this->spline2);
+    }
 
-        // remove radians for artsy shapes
-        GLfloat angle = glm::radians(360.0f / this->dataModel->spans);
+    this->setDrawStage(Spline::DrawStage::THREE);
+    // } regenerate
 
-        for(uint16_t s = 0; s < this->dataModel->spans; s++)
-        {
-            // rotateCurve
-            for(uint16_t p = 0; p < this->spline1.size(); p++)
-            {
-                glm::vec3 p1 = this->splines[p + (s * this->spline1.size())];
-                glm::vec3 p2 = glm::rotateZ(p1, angle);
-                this->splines.push_back(p2);
-            }
-        }
-    }
+    if (this->instancedSweep)
+        this->sweepInstanced();
+    else
+        this->sweepSplines();
+}
+
+void Spline::sweepSplines()
+{
+    this->splinesNormals.clear();
+
+    if (this->lit && this->getSweepType() ==
+                     DataModel::SweepType::Translational)
+        this->sweeper.sweepTranslational(this->spline1, this->spline1Tangents,
+                                         this->spline2, this->spline2Tangents,
+                                         this->splines, this->splinesNormals);
+    else if (this->lit)
+        this->sweeper.sweepRotational(this->spline1, this->spline1Tangents,
+                                      this->dataModel->spans, this->splines,
+                                      this->splinesNormals);
+    else if (this->getSweepType() == DataModel::SweepType::Translational)
+        this->sweeper.sweepTranslational(this->spline1, this->spline2,
+                                         this->splines);
+    else
+        this->sweeper.sweepRotational(this->spline1, this->dataModel->spans,
+                                      this->splines);
+}
+
+void Spline::sweepInstanced()
+{
+    this->splines.clear();
+    this->splinesNormals.clear();
+    this->splinesIndices.clear();
+    this->splinesTriangles = 0;
+
+    this->sweeper.sweepTransforms(this->getSweepType(), this->spline2,
+                                  this->dataModel->spans,
+                                  this->sweepTransforms);
+    this->instancedSweep->uploadProfile(this->spline1);
+    this->instancedSweep->uploadTransforms(this->getSweepType(),
+                                           this->sweepTransforms);
 }
 
 void Spline::genSplinesIndices()
 {
+    // swept on the gpu, nothing to index
+    if (this->instancedSweep || this->tessellating)
+        return;
+
     // TODO reduce number of vertices depending in renderMode
     // if (renderMode == GL_TRIANGLES)
 
-    uint16_t sweeps;
+    size_t sweeps = 0;
 
     if (this->getSweepType() == DataModel::SweepType::Translational)
         sweeps = this->spline2.size();
@@ -344,47 +907,230 @@ void Spline::genSplinesIndices()
     else if (this->getSweepType() == DataModel::SweepType::Rotational)
         sweeps = this->dataModel->spans;
 
-    this->splinesIndices.clear();
+    this->sweeper.genIndices(this->spline1.size(), sweeps,
+                             this->splinesIndices);
+    this->splinesTriangles = this->splinesIndices.triangleCount();
+    this->ebo.invalidate();
+
+    this->lodSamples = std::max(this->spline1.size(), sweeps + 1);
+    this->genLods();
+}
+
+// every step-th sample, the last one kept for the curve to end alike
+static void decimate(const std::vector<glm::vec3> &samples,
+                     const size_t step, std::vector<glm::vec3> &decimated)
+{
+    decimated.clear();
 
-    uint16_t p1, p2;
+    for (size_t i = 0; i < samples.size(); i += step)
+        decimated.push_back(samples[i]);
+    if (!samples.empty() && (samples.size() - 1) % step != 0)
+        decimated.push_back(samples.back());
+}
 
-    // translational & rotational
-    for (uint16_t s = 0; s < sweeps; s++)
+void Spline::genBounds()
+{
+    // bounding sphere around the center of the bounding box
+    glm::vec3 low(HUGE_VALF), high(-HUGE_VALF);
+    for (const auto &v: this->splines)
     {
-        for (uint16_t p = 0; p < this->spline1.size() - 1; p++)
+        low = glm::min(low, v);
+        high = glm::max(high, v);
+    }
+    this->boundsCenter = (low + high) * 0.5f;
+    this->boundsRadius = 0;
+    for (const auto &v: this->splines)
+        this->boundsRadius = std::max(this->boundsRadius,
+                                      glm::length(v - this->boundsCenter));
+}
+
+void Spline::genLods()
+{
+    size_t levels = 0;
+    std::vector<glm::vec3> &profile = this->lodProfile;
+    std::vector<glm::vec3> &trajectory = this->lodTrajectory;
+    std::vector<glm::vec3> &profileTangents = this->lodProfileTangents;
+    std::vector<glm::vec3> &trajectoryTangents = this->lodTrajectoryTangents;
+    bool normals = !this->splinesNormals.empty();
+    bool rotational = (this->getSweepType() ==
+                       DataModel::SweepType::Rotational);
+
+    this->genBounds();
+
+    for (size_t k = 1; k <= this->lodLevels; k++)
+    {
+        size_t step = (size_t) 1 << k;
+        size_t sweeps;
+
+        decimate(this->spline1, step, profile);
+        // nothing coarser left
+        if (profile.size() < 4 || profile.size() == this->spline1.size())
+            break;
+
+        if (this->lods.size() < k)
+            this->lods.push_back(new SplineLod());
+        SplineLod *lod = this->lods[k - 1];
+
+        lod->normals.clear();
+        if (normals)
+            decimate(this->spline1Tangents, step, profileTangents);
+
+        if (rotational)
         {
-            p1 = p + this->spline1.size() * s;
-            p2 = p + this->spline1.size() * (s + 1);
-
-            // Triangle 1
-            this->splinesIndices.push_back(p1);
-            this->splinesIndices.push_back(p1 + 1);
-            this->splinesIndices.push_back(p2);
-
-            // Triangle 2
-            this->splinesIndices.push_back(p1 + 1);
-            this->splinesIndices.push_back(p2);
-            this->splinesIndices.push_back(p2 + 1);
+            sweeps = std::max((size_t) this->dataModel->spans >> k,
+                              (size_t) 3);
+            if (normals)
+                this->sweeper.sweepRotational(profile, profileTangents,
+                                              sweeps, lod->vertices,
+                                              lod->normals);
+            else
+                this->sweeper.sweepRotational(profile, sweeps,
+                                              lod->vertices);
         }
+        else
+        {
+            decimate(this->spline2, step, trajectory);
+            sweeps = trajectory.size();
+            if (normals)
+            {
+                decimate(this->spline2Tangents, step, trajectoryTangents);
+                this->sweeper.sweepTranslational(profile, profileTangents,
+                                                 trajectory,
+                                                 trajectoryTangents,
+                                                 lod->vertices,
+                                                 lod->normals);
+            }
+            else
+            {
+                this->sweeper.sweepTranslational(profile, trajectory,
+                                                 lod->vertices);
+            }
+        }
+        this->sweeper.genIndices(profile.size(), sweeps, lod->indices);
+
+        if (this->weldVertices)
+        {
+            Welder welder;
+            if (normals)
+                welder.weldSweep(this->getSweepType(), profile.size(),
+                                 lod->vertices, lod->normals, lod->indices);
+            else
+                welder.weldSweep(this->getSweepType(), profile.size(),
+                                 lod->vertices, lod->indices);
+        }
+        lod->triangles = lod->indices.triangleCount();
+        lod->vbo.invalidate();
+        lod->ebo.invalidate();
+        levels = k;
+    }
+
+    while (this->lods.size() > levels)
+    {
+        delete this->lods.back();
+        this->lods.pop_back();
     }
+    this->lod = std::min(this->lod, this->lods.size());
+    this->lodsDirty = false;
+}
+
+size_t Spline::getLodLevels() const
+{
+    return this->lodLevels;
 }
 
-std::vector<glm::vec3> Spline::translateProfileCurve(
-    std::vector<glm::vec3> p, glm::vec3 t)
+void Spline::setLodLevels(const size_t levels)
 {
-    std::vector<glm::vec3> new_p;
+    this->lodLevels = levels;
+}
+
+void Spline::selectLod(const glm::mat4 &view, const glm::mat4 &projection,
+                       const float viewportHeight)
+{
+    if (this->lods.empty() ||
+        this->drawStage != Spline::DrawStage::THREE)
+    {
+        this->lod = 0;
+        return;
+    }
 
-    for(const auto& p_n: p)
+    glm::vec4 center = view * this->model *
+                       glm::vec4(this->boundsCenter, 1.0f);
+    float distance = -center.z;
+
+    // the camera within the sphere
+    if (distance <= this->boundsRadius)
     {
-        glm::vec3 vec(p_n + t);
+        this->lod = 0;
+        return;
+    }
 
-        new_p.push_back(vec);
-        //printf("(%f, %f, %f) + (%f, %f, %f) \n= (%f, %f, %f)\n",
-        //        v[0], v[1], v[2], t[0], t[1], t[2], vec[0], vec[1], vec[2]);
+    // projected diameter in pixels, perspective projection
+    float pixels = this->boundsRadius * projection[1][1] *
+                   viewportHeight / distance;
+    float level = log2f(this->lodSamples * lodSamplePixels /
+                        std::max(pixels, 1.0f));
 
+    // kept while within its own range widened by the hysteresis
+    if (level < this->lod - lodHysteresis ||
+        level >= this->lod + 1 + lodHysteresis)
+    {
+        level = std::min(std::max(level, 0.0f), (float) this->lods.size());
+        this->lod = (size_t) level;
     }
-    //printf("--------------------------------------------------\n");
-    return new_p;
+
+    // edited up close, caught up once small enough on screen
+    if (this->lod > 0 && this->lodsDirty)
+    {
+        this->arena.reset();
+        this->genLods();
+        this->uploadLods();
+    }
+}
+
+size_t Spline::getLod() const
+{
+    return this->lod;
+}
+
+bool Spline::getWeld() const
+{
+    return this->weldVertices;
+}
+
+void Spline::setWeld(const bool weld)
+{
+    this->weldVertices = weld;
+}
+
+IndexBuffer::Topology Spline::getTopology() const
+{
+    return this->sweeper.getTopology();
+}
+
+void Spline::setTopology(const IndexBuffer::Topology topology)
+{
+    this->sweeper.setTopology(topology);
+}
+
+void Spline::weld()
+{
+    if (!this->weldVertices || this->instancedSweep || this->tessellating)
+        return;
+
+    Welder welder;
+    WeldStats stats = this->splinesNormals.empty() ?
+        welder.weldSweep(this->getSweepType(), this->spline1.size(),
+                         this->splines, this->splinesIndices) :
+        welder.weldSweep(this->getSweepType(), this->spline1.size(),
+                         this->splines, this->splinesNormals,
+                         this->splinesIndices);
+
+    this->splinesTriangles = this->splinesIndices.triangleCount();
+    this->vbo.invalidate();
+    this->ebo.invalidate();
+
+    printf("Welded %zu of %zu vertices, %zu degenerate triangles removed.\n",
+           stats.removedVertices, stats.vertices, stats.removedTriangles);
 }
 
 void Spline::printVertices()
@@ -401,13 +1147,13 @@ void Spline::printVertices()
 
 void Spline::printVerticesIndices() const
 {
-    for(uint16_t i = 0; i < this->splinesIndices.size(); i++)
+    for(size_t i = 0; i < this->splinesIndices.size(); i++)
     {
         if (i % 3 == 0)
         {
             printf("\n");
         }
-        printf("%i ", this->splinesIndices[i]);
+        printf("%u ", this->splinesIndices.at(i));
     }
     printf("\n");
 }
@@ -417,17 +1163,8 @@ bool Spline::saveData()
     if (this->drawStage != Spline::DrawStage::THREE)
         return false;
 
-    this->dataModel->deleteFile();
-
-    this->dataModel->saveNumber(this->getSweepType());
-
-    if (this->getSweepType() == DataModel::SweepType::Rotational)
-        this->dataModel->saveNumber(this->dataModel->spans);
-
-    this->dataModel->saveVertices(this->dataModel->profileVertices);
-
-    if (this->getSweepType() == DataModel::SweepType::Translational)
-        this->dataModel->saveVertices(this->dataModel->trajectoryVertices);
+    if (!this->dataModel->saveFile())
+        return false;
 
     // TODO change for filepath once implemented
     printf("Data saved to %s.\n", this->dataModel->getFilename().c_str());
@@ -453,58 +1190,12 @@ bool Spline::genCatmullRomSpline()
         return false;
     }
 
-    GLfloat s = 0.5f;
-
-    glm::mat4 basis(
-        -s,     2-s,    s-2,    s,      // [0][0]-[0][3]
-        2*s,    s-3,    3-2*s,  -s,
-        -s,     0,      s,      0,
-        0,      1,      0,      0
-    );
-
-    float tmax = 10.0f;
-    float step = 1.0f / tmax;
-
-    // add artificial before first
-    //drawVertices->insert(drawVertices->begin(), drawVertices->at(0) - step);
-    // add artificial after last
-    //drawVertices->push_back(drawVertices->at(drawVertices->size()-1) + step);
-
-    std::vector<glm::vec3> vbuffer;
-
-    // for n segments with n+3 control points
-    for (uint16_t i = 1; i < drawVertices->size() - 2; i++)
-    {
-        // brute force (for n segments)
-        for (float t = 0.0f; t < 1.0f - step; t += step)
-        {
-            glm::vec3 p0 = drawVertices->at(i - 1);
-            glm::vec3 p1 = drawVertices->at(i);
-            glm::vec3 p2 = drawVertices->at(i + 1);
-            glm::vec3 p3 = drawVertices->at(i + 2);
-
-            glm::vec4 params = glm::vec4(t*t*t, t*t, t, 1.0f);
-
-            glm::mat4x3 control(p0, p1, p2, p3);
-
-            /* operations order:
-             *      mat4 * vec4 -> vec4 is column vector
-             *      vec4 * mat4 -> vec4 is row vector
-             */
-
-            glm::vec3 pn = params * (
-                    glm::transpose(basis) * glm::transpose(control)
-            );
-            //printf("\n p_%i t=%f (%f, %f, %f)\n\n", i, t, pn.x, pn.y, pn.z);
-
-            vbuffer.push_back(pn);
-        }
-    }
-
-    drawVertices->clear();
+    this->arena.reset();
+    this->sweeper.getCurve().evaluate(*drawVertices, this->curveSamples);
 
-    for (uint16_t i = 0; i < vbuffer.size(); i++)
-        this->addDrawVertex(vbuffer.at(i));
+    // both keep their storage for the next curve
+    drawVertices->swap(this->curveSamples);
+    this->vbo.invalidate();
 
     return true;
 }
@@ -14,7 +14,6 @@
 
 #include <math.h>
 #include <glm/glm.hpp>
-#include "glm/gtx/rotate_vector.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -23,7 +22,31 @@
 #include "Camera.hpp"
 
 #include "Mesh.hpp"
+#include "GpuBuffer.hpp"
+#include "FrameUniforms.hpp"
+#include "FrameProfiler.hpp"
+#include "InstancedSweep.hpp"
+#include "TessellatedSweep.hpp"
+#include "StreamingCurve.hpp"
 #include "DataModel.hpp"
+#include "Sweeper.hpp"
+#include "Welder.hpp"
+
+// coarser copy of the swept surface with its own buffers, see genLods
+struct SplineLod
+{
+    SplineLod();
+    ~SplineLod();
+
+    std::vector<glm::vec3> vertices;
+    // lit only, and both interleaved as uploaded
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> interleaved;
+    IndexBuffer indices;
+    size_t triangles = 0;
+    GLuint vaoId;
+    GpuBuffer vbo, ebo;
+};
 
 class Spline : public Mesh
 {
@@ -51,9 +74,9 @@ class Spline : public Mesh
         void setDrawStage(const DrawStage drawStage);
 
         void render(const Window* window,
-                    const Camera* camera,
-                    const glm::mat4 view,
-                    const glm::mat4 projection);
+                    const Camera* camera);
+        // submitted by the last render
+        const DrawStats& getDrawStats() const;
 
         std::vector<glm::vec3>* getDataVertices();
         std::vector<glm::vec3>* getDrawVertices();
@@ -63,13 +86,92 @@ class Spline : public Mesh
 
         void uploadVertices();
 
-        void setSpans(const uint16_t spans);
+        // resweeps a rotational surface already drawn
+        uint32_t getSpans() const;
+        void setSpans(const uint32_t spans);
+
+        // surface swept by the vertex shader, nothing materialized
+        bool getInstanced() const;
+        void setInstanced(const bool instanced);
+
+        // surface evaluated by the tessellation stages, needs GL 4.0
+        bool getTessellated() const;
+        void setTessellated(const bool tessellated);
+
+        /*
+         * Control points appended one at a time, the last capacity
+         * samples of their curve drawn instead of anything else and
+         * nothing kept in the DataModel; 0 turns it off.
+        */
+        bool isStreaming() const;
+        void setStreaming(const size_t capacity);
+        void appendControlPoint(const glm::vec3 &point);
+
+        /*
+         * Shaded with the normals swept along with the surface, from
+         * the curve derivatives, uploaded interleaved with the vertices;
+         * the surface materialized on the cpu only, from the next sweep.
+        */
+        bool getLit() const;
+        void setLit(const bool lit);
+
+        // picked at generation time, draw() follows it
+        IndexBuffer::Topology getTopology() const;
+        void setTopology(const IndexBuffer::Topology topology);
 
         void genSplinesIndices();
+
+        /*
+         * Coarser surfaces, every level halving the profile samples and
+         * the sweeps (3 at least), drawn instead of the full one once
+         * it gets small on screen; 0 disables them.
+        */
+        size_t getLodLevels() const;
+        void setLodLevels(const size_t levels);
+        // before render, from the projected size of the bounding sphere
+        void selectLod(const glm::mat4 &view, const glm::mat4 &projection,
+                       const float viewportHeight);
+        // 0 for the full surface
+        size_t getLod() const;
         bool genCatmullRomSpline();
 
         void sweep();
 
+        // optional, after genSplinesIndices
+        bool getWeld() const;
+        void setWeld(const bool weld);
+        void weld();
+
+        /*
+         * Edits a control point of the swept profile (curve ONE) or
+         * trajectory (TWO) and regenerates and uploads only what it
+         * reaches; false before the sweep, out of range or deleting one
+         * of the last 4.
+        */
+        bool moveControlPoint(const DrawStage curve, const size_t i,
+                              const glm::vec3 &point);
+        bool insertControlPoint(const DrawStage curve, const size_t i,
+                                const glm::vec3 &point);
+        bool deleteControlPoint(const DrawStage curve, const size_t i);
+
+        /*
+         * The control point drawn nearest to the cursor (window
+         * coordinates, y up) within radius pixels: of the profile (ONE)
+         * as swept at its first copy, or of the trajectory (TWO) where
+         * it carries the first profile point, its first one pinned there.
+        */
+        bool pickControlPoint(const glm::vec2 &cursor, const glm::mat4 &view,
+                              const glm::mat4 &projection,
+                              const glm::vec2 &viewport, const float radius,
+                              DrawStage &curve, size_t &i) const;
+        glm::vec3 getControlPoint(const DrawStage curve,
+                                  const size_t i) const;
+        // moved under the cursor, at the depth it is drawn at
+        bool dragControlPoint(const DrawStage curve, const size_t i,
+                              const glm::vec2 &cursor, const glm::mat4 &view,
+                              const glm::mat4 &projection,
+                              const glm::vec2 &viewport);
+
         void rotate(const glm::vec3 axesSpins);
 
         void printVertices();
@@ -77,23 +179,80 @@ class Spline : public Mesh
 
     private:
         void initBuffers();
+        void sweepSplines();
+        void sweepInstanced();
+        // boundsCenter and boundsRadius of the swept surface
+        void genBounds();
+        void genLods();
+        void uploadLods();
 
-        std::vector<glm::vec3> translateProfileCurve(
-            std::vector<glm::vec3> p, glm::vec3 t);
+        std::vector<glm::vec3>* getControlPoints(const DrawStage curve);
+        std::vector<glm::vec3>* getSamples(const DrawStage curve);
+        void regenerate(const DrawStage curve, const SampleRange &changed);
+        // model space, where pickControlPoint finds it
+        glm::vec3 getControlPointPosition(const DrawStage curve,
+                                          const size_t i) const;
 
         void draw();
 
         Shader *shader;
-        GLuint vboId, vaoId, eboId;
+        GLint modelLoc, colorizeLoc;
+        // the surface once swept with its normals
+        Shader *litShader = NULL;
+        GLint litModelLoc;
+        // model & colorize to send again before the next draw
+        bool uniformsDirty = true;
+        GLuint vaoId;
+        // uploaded by changed range, see uploadVertices
+        GpuBuffer vbo, ebo;
+        const std::vector<glm::vec3> *uploadedVertices = NULL;
         GLenum renderMode;
         DrawStage drawStage;
         // in/output file data
         DataModel *dataModel;
+        // geometry core shared with the headless tools
+        Sweeper sweeper;
+        ThreadPool *pool;
+        // scratch of the sweeper, reset by every regeneration
+        Arena arena;
+        bool weldVertices = false;
         // splines over data
         std::vector<glm::vec3> spline1;
         std::vector<glm::vec3> spline2;
         std::vector<glm::vec3> splines;
-        std::vector<GLushort> splinesIndices;
+        IndexBuffer splinesIndices;
+        // of the curves then the surface, lit only
+        bool lit = false;
+        std::vector<glm::vec3> spline1Tangents;
+        std::vector<glm::vec3> spline2Tangents;
+        std::vector<glm::vec3> splinesNormals;
+        // vertex, normal, ... as uploaded
+        std::vector<glm::vec3> splinesInterleaved;
+        // swapped with the curve drawn by genCatmullRomSpline
+        std::vector<glm::vec3> curveSamples;
+        // instead of splines & indices when set
+        InstancedSweep *instancedSweep = NULL;
+        std::vector<glm::vec4> sweepTransforms;
+        // from the control points, preferred over instancedSweep
+        TessellatedSweep *tessellatedSweep = NULL;
+        // set by sweep(), false below 4 control points
+        bool tessellating = false;
+        size_t splinesTriangles = 0;
+        // level k + 1 in lods[k], generated with the indices
+        std::vector<SplineLod*> lods;
+        // decimated curves, kept for their capacity
+        std::vector<glm::vec3> lodProfile, lodTrajectory;
+        std::vector<glm::vec3> lodProfileTangents, lodTrajectoryTangents;
+        size_t lodLevels = 0;
+        size_t lod = 0;
+        // behind the full surface after an edit, until drawn again
+        bool lodsDirty = false;
+        // samples along the longest side of the full surface
+        size_t lodSamples = 0;
+        glm::vec3 boundsCenter;
+        float boundsRadius = 0;
+        DrawStats drawStats;
+        StreamingCurve *streamingCurve = NULL;
         // coordinate system
         glm::mat4 model;
         // used for rotation
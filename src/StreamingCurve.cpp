@@ -0,0 +1,113 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "StreamingCurve.hpp"
+
+#include <algorithm>
+
+StreamingCurve::StreamingCurve(const CatmullRom &curve,
+                               const size_t capacity) :
+    stream(curve, capacity)
+{
+    glGenVertexArrays(1, &this->vaoId);
+    glGenBuffers(1, &this->vboId);
+
+    glBindVertexArray(this->vaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vboId);
+
+    // the whole ring, never reallocated
+    glBufferData(GL_ARRAY_BUFFER,
+                 sizeof(glm::vec3) * (this->stream.getCapacity() + 1),
+                 NULL, GL_STREAM_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(glm::vec3), NULL);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+StreamingCurve::~StreamingCurve()
+{
+    glDeleteBuffers(1, &this->vboId);
+    glDeleteVertexArrays(1, &this->vaoId);
+}
+
+CurveStream& StreamingCurve::getStream()
+{
+    return this->stream;
+}
+
+void StreamingCurve::uploadSlots(const size_t first, const size_t count)
+{
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * first,
+                    sizeof(glm::vec3) * count, this->stream.data() + first);
+}
+
+void StreamingCurve::upload()
+{
+    // cleared since
+    if (this->stream.written() < this->uploaded)
+        this->uploaded = 0;
+
+    size_t capacity = this->stream.getCapacity();
+    uint64_t pending = this->stream.written() - this->uploaded;
+
+    if (pending == 0)
+        return;
+
+    // older ones were overwritten in the ring anyway
+    size_t count = (size_t) std::min(pending, (uint64_t) capacity);
+    size_t head = this->stream.head();
+    size_t first = (head + capacity - count) % capacity;
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->vboId);
+
+    if (first + count <= capacity)
+    {
+        this->uploadSlots(first, count);
+    }
+    else
+    {
+        this->uploadSlots(first, capacity - first);
+        this->uploadSlots(0, first + count - capacity);
+    }
+    // the copy of the first slot, after the last one
+    if (first == 0 || first + count > capacity)
+        this->uploadSlots(capacity, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    this->uploaded = this->stream.written();
+}
+
+void StreamingCurve::draw(const GLenum renderMode, DrawStats &stats)
+{
+    GLint first[2];
+    GLsizei count[2];
+    size_t rangeFirst[2], rangeCount[2];
+
+    stats = DrawStats();
+
+    size_t ranges = this->stream.ranges(rangeFirst, rangeCount);
+    if (ranges == 0)
+        return;
+
+    for (size_t r = 0; r < ranges; r++)
+    {
+        first[r] = rangeFirst[r];
+        count[r] = rangeCount[r];
+    }
+
+    GLenum mode = (renderMode == GL_POINTS) ? GL_POINTS : GL_LINE_STRIP;
+
+    glBindVertexArray(this->vaoId);
+    glMultiDrawArrays(mode, first, count, ranges);
+    glBindVertexArray(0);
+
+    stats.drawCalls = 1;
+    stats.vertices = this->stream.size();
+}
@@ -0,0 +1,44 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief CurveStream drawn from a fixed size gpu ring buffer
+*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CurveStream.hpp"
+#include "FrameProfiler.hpp"
+
+/*
+ * The buffer mirrors the ring of the stream, allocated once: every
+ * upload() sends the samples written since the previous one, in at
+ * most 3 ranges, and a draw is one glMultiDrawArrays over the two
+ * ranges of CurveStream::ranges.
+*/
+class StreamingCurve
+{
+    public:
+        StreamingCurve(const CatmullRom &curve, const size_t capacity);
+        ~StreamingCurve();
+
+        CurveStream& getStream();
+
+        // the new samples, a no-op without any
+        void upload();
+        // the vertex attribute 0 of the bound program, GL_POINTS or a
+        // line strip
+        void draw(const GLenum renderMode, DrawStats &stats);
+
+    private:
+        void uploadSlots(const size_t first, const size_t count);
+
+        CurveStream stream;
+        GLuint vaoId;
+        GLuint vboId;
+        // stream samples on the gpu
+        uint64_t uploaded = 0;
+};
@@ -0,0 +1,891 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "Sweeper.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SWEEPER_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Rotational kernels: a span is the SoA profile curve rotated about z,
+ * x' + iy' = (x + iy)(c + is), vectorized over the profile points.
+*/
+
+typedef void (*RotateFunction)(const float *x, const float *y,
+                               const float *z, const size_t points,
+                               const float c, const float s,
+                               glm::vec3 *polygon);
+
+static inline void rotatePoints(const float *x, const float *y,
+                                const float *z,
+                                const size_t first, const size_t last,
+                                const float c, const float s,
+                                glm::vec3 *polygon)
+{
+    for (size_t p = first; p < last; p++)
+        polygon[p] = glm::vec3(x[p] * c - y[p] * s, x[p] * s + y[p] * c, z[p]);
+}
+
+static void rotateScalar(const float *x, const float *y, const float *z,
+                         const size_t points, const float c, const float s,
+                         glm::vec3 *polygon)
+{
+    rotatePoints(x, y, z, 0, points, c, s, polygon);
+}
+
+#if defined(SWEEPER_X86)
+
+static void rotateSSE(const float *x, const float *y, const float *z,
+                      const size_t points, const float c, const float s,
+                      glm::vec3 *polygon)
+{
+    size_t p = 0;
+    float ox[4], oy[4];
+    __m128 vc = _mm_set1_ps(c), vs = _mm_set1_ps(s);
+
+    for (; p + 4 <= points; p += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + p), vy = _mm_loadu_ps(y + p);
+
+        _mm_storeu_ps(ox, _mm_sub_ps(_mm_mul_ps(vx, vc), _mm_mul_ps(vy, vs)));
+        _mm_storeu_ps(oy, _mm_add_ps(_mm_mul_ps(vx, vs), _mm_mul_ps(vy, vc)));
+
+        for (size_t l = 0; l < 4; l++)
+            polygon[p + l] = glm::vec3(ox[l], oy[l], z[p + l]);
+    }
+    rotatePoints(x, y, z, p, points, c, s, polygon);
+}
+
+__attribute__((target("avx2")))
+static void rotateAVX2(const float *x, const float *y, const float *z,
+                       const size_t points, const float c, const float s,
+                       glm::vec3 *polygon)
+{
+    size_t p = 0;
+    float ox[8], oy[8];
+    __m256 vc = _mm256_set1_ps(c), vs = _mm256_set1_ps(s);
+
+    for (; p + 8 <= points; p += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + p), vy = _mm256_loadu_ps(y + p);
+
+        _mm256_storeu_ps(ox, _mm256_sub_ps(_mm256_mul_ps(vx, vc),
+                                           _mm256_mul_ps(vy, vs)));
+        _mm256_storeu_ps(oy, _mm256_add_ps(_mm256_mul_ps(vx, vs),
+                                           _mm256_mul_ps(vy, vc)));
+
+        for (size_t l = 0; l < 8; l++)
+            polygon[p + l] = glm::vec3(ox[l], oy[l], z[p + l]);
+    }
+    rotatePoints(x, y, z, p, points, c, s, polygon);
+}
+
+#elif defined(__ARM_NEON)
+
+static void rotateNEON(const float *x, const float *y, const float *z,
+                       const size_t points, const float c, const float s,
+                       glm::vec3 *polygon)
+{
+    size_t p = 0;
+    float ox[4], oy[4];
+
+    for (; p + 4 <= points; p += 4)
+    {
+        float32x4_t vx = vld1q_f32(x + p), vy = vld1q_f32(y + p);
+
+        vst1q_f32(ox, vmlsq_n_f32(vmulq_n_f32(vx, c), vy, s));
+        vst1q_f32(oy, vmlaq_n_f32(vmulq_n_f32(vx, s), vy, c));
+
+        for (size_t l = 0; l < 4; l++)
+            polygon[p + l] = glm::vec3(ox[l], oy[l], z[p + l]);
+    }
+    rotatePoints(x, y, z, p, points, c, s, polygon);
+}
+
+#endif
+
+// same kernel family as the one picked for the curve
+static RotateFunction rotateFunction(const CatmullRom::Kernel kernel)
+{
+    switch (kernel)
+    {
+#if defined(SWEEPER_X86)
+        case CatmullRom::Kernel::SSE:
+            return rotateSSE;
+        case CatmullRom::Kernel::AVX2:
+            return rotateAVX2;
+#elif defined(__ARM_NEON)
+        case CatmullRom::Kernel::NEON:
+            return rotateNEON;
+#endif
+        default:
+            return rotateScalar;
+    }
+}
+
+// unit length, or 0 where the direction vanishes
+static inline glm::vec3 unit(const glm::vec3 &v)
+{
+    float length = glm::length(v);
+    return (length > 1e-12f) ? v / length : glm::vec3(0.0f);
+}
+
+// the closest valid one, the previous first, for every vanished normal
+static void fillNormals(glm::vec3 *normals, const size_t count)
+{
+    size_t valid = count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (normals[i] != glm::vec3(0.0f))
+        {
+            // the leading ones take the first valid one
+            if (valid == count)
+                std::fill(normals, normals + i, normals[i]);
+            valid = i;
+        }
+        else if (valid < count)
+        {
+            normals[i] = normals[valid];
+        }
+    }
+}
+
+// of a curve too short for a spline, swept as is
+static void polylineTangents(const std::vector<glm::vec3> &points,
+                             std::vector<glm::vec3> &tangents)
+{
+    size_t count = points.size();
+
+    tangents.resize(count);
+    for (size_t i = 0; i < count; i++)
+        tangents[i] = points[std::min(i + 1, count - 1)] -
+                      points[(i > 0) ? i - 1 : 0];
+}
+
+Sweeper::Sweeper()
+{
+}
+
+Sweeper::Sweeper(const CatmullRom &curve) :
+    curve(curve)
+{
+}
+
+Sweeper::~Sweeper()
+{
+}
+
+const CatmullRom& Sweeper::getCurve() const
+{
+    return this->curve;
+}
+
+size_t Sweeper::getMeshletVertices() const
+{
+    return this->meshletVertices;
+}
+
+void Sweeper::setMeshletVertices(const size_t vertices)
+{
+    this->meshletVertices = (vertices > 65536) ? 65536 : vertices;
+}
+
+IndexBuffer::Topology Sweeper::getTopology() const
+{
+    return this->topology;
+}
+
+void Sweeper::setTopology(const IndexBuffer::Topology topology)
+{
+    this->topology = topology;
+}
+
+Arena* Sweeper::getArena() const
+{
+    return this->arena;
+}
+
+void Sweeper::setArena(Arena *arena)
+{
+    this->arena = arena;
+    this->curve.setArena(arena);
+}
+
+bool Sweeper::getNormals() const
+{
+    return this->normals;
+}
+
+void Sweeper::setNormals(const bool normals)
+{
+    this->normals = normals;
+}
+
+ThreadPool* Sweeper::getThreadPool() const
+{
+    return this->pool;
+}
+
+void Sweeper::setThreadPool(ThreadPool *pool)
+{
+    this->pool = pool;
+}
+
+void Sweeper::forEach(const size_t begin, const size_t end,
+                      const size_t grain,
+                      const ThreadPool::RangeTask &task) const
+{
+    if (this->pool)
+        this->pool->parallelFor(begin, end, grain, task);
+    else
+        task(begin, end);
+}
+
+bool Sweeper::sweep(const DataModel &dataModel, SweepMesh &mesh) const
+{
+    const std::vector<glm::vec3> &profile = dataModel.profileVertices;
+    const std::vector<glm::vec3> &trajectory = dataModel.trajectoryVertices;
+
+    return this->sweep(dataModel.getSweepType(), dataModel.spans,
+                       profile.empty() ? NULL : &profile[0], profile.size(),
+                       trajectory.empty() ? NULL : &trajectory[0],
+                       trajectory.size(), mesh);
+}
+
+bool Sweeper::sweep(const DataModel::SweepType sweepType, const size_t spans,
+                    const glm::vec3 *profile, const size_t profilePoints,
+                    const glm::vec3 *trajectory, const size_t trajectoryPoints,
+                    SweepMesh &mesh) const
+{
+    bool normals = this->normals;
+
+    if (normals)
+        this->tessellate(profile, profilePoints, mesh.profile,
+                         mesh.profileTangents);
+    else
+        this->tessellate(profile, profilePoints, mesh.profile);
+
+    if (mesh.profile.size() < 2)
+        return false;
+
+    if (!normals)
+    {
+        mesh.profileTangents.clear();
+        mesh.trajectoryTangents.clear();
+        mesh.normals.clear();
+    }
+
+    if (sweepType == DataModel::SweepType::Translational)
+    {
+        if (normals)
+            this->tessellate(trajectory, trajectoryPoints, mesh.trajectory,
+                             mesh.trajectoryTangents);
+        else
+            this->tessellate(trajectory, trajectoryPoints, mesh.trajectory);
+
+        if (mesh.trajectory.empty())
+            return false;
+
+        this->sweepTranslational(mesh.profile,
+                                 normals ? &mesh.profileTangents : NULL,
+                                 mesh.trajectory,
+                                 normals ? &mesh.trajectoryTangents : NULL,
+                                 mesh.vertices,
+                                 normals ? &mesh.normals : NULL);
+        mesh.sweeps = mesh.trajectory.size();
+    }
+    else
+    {
+        if (spans == 0)
+            return false;
+
+        mesh.trajectory.clear();
+        mesh.trajectoryTangents.clear();
+        this->sweepRotational(mesh.profile,
+                              normals ? &mesh.profileTangents : NULL,
+                              spans, mesh.vertices,
+                              normals ? &mesh.normals : NULL);
+        mesh.sweeps = spans;
+    }
+
+    this->genIndices(mesh.profile.size(), mesh.sweeps, mesh.indices);
+    return true;
+}
+
+void Sweeper::tessellate(const std::vector<glm::vec3> &controlPoints,
+                         std::vector<glm::vec3> &samples) const
+{
+    this->tessellate(controlPoints.empty() ? NULL : &controlPoints[0],
+                     controlPoints.size(), samples);
+}
+
+void Sweeper::tessellate(const glm::vec3 *controlPoints, const size_t points,
+                         std::vector<glm::vec3> &samples) const
+{
+    // as in the interactive path: too short for a spline, sweep as is
+    if (!this->curve.evaluate(controlPoints, points, samples))
+        samples.assign(controlPoints, controlPoints + points);
+}
+
+void Sweeper::tessellate(const std::vector<glm::vec3> &controlPoints,
+                         std::vector<glm::vec3> &samples,
+                         std::vector<glm::vec3> &tangents) const
+{
+    this->tessellate(controlPoints.empty() ? NULL : &controlPoints[0],
+                     controlPoints.size(), samples, tangents);
+}
+
+void Sweeper::tessellate(const glm::vec3 *controlPoints, const size_t points,
+                         std::vector<glm::vec3> &samples,
+                         std::vector<glm::vec3> &tangents) const
+{
+    if (!this->curve.evaluate(controlPoints, points, samples, tangents))
+    {
+        samples.assign(controlPoints, controlPoints + points);
+        polylineTangents(samples, tangents);
+    }
+}
+
+bool Sweeper::incremental(const size_t controlPoints,
+                          const size_t samples) const
+{
+    return this->curve.getSubdivision() == CatmullRom::Subdivision::Uniform &&
+           controlPoints >= 4 &&
+           samples == this->curve.uniformSamples(controlPoints);
+}
+
+SampleRange Sweeper::retessellate(const std::vector<glm::vec3> &controlPoints,
+                                  std::vector<glm::vec3> &samples) const
+{
+    this->tessellate(controlPoints, samples);
+
+    SampleRange range = {0, samples.size(), true};
+    return range;
+}
+
+SampleRange Sweeper::evaluateSegments(
+    const std::vector<glm::vec3> &controlPoints,
+    const size_t first, const size_t last, const bool resized,
+    std::vector<glm::vec3> &samples) const
+{
+    size_t segmentSamples = this->curve.getSegmentSamples();
+
+    this->curve.evaluateSegments(&controlPoints[0], controlPoints.size(),
+                                 first, last, &samples[0]);
+
+    SampleRange range = {first * segmentSamples,
+                         resized ? samples.size() : last * segmentSamples,
+                         resized};
+    return range;
+}
+
+/*
+ * Segment j is weighed by control points j to j + 3: an edit of point
+ * i reaches segments [i - 3, i], those past it are shifted by as many
+ * samples as a segment when inserting or erasing.
+*/
+
+SampleRange Sweeper::moveControlPoint(std::vector<glm::vec3> &controlPoints,
+                                      std::vector<glm::vec3> &samples,
+                                      const size_t i,
+                                      const glm::vec3 &point) const
+{
+    controlPoints[i] = point;
+
+    if (!this->incremental(controlPoints.size(), samples.size()))
+        return this->retessellate(controlPoints, samples);
+
+    size_t segments = controlPoints.size() - 3;
+
+    return this->evaluateSegments(controlPoints, i < 3 ? 0 : i - 3,
+                                  std::min(i + 1, segments), false, samples);
+}
+
+SampleRange Sweeper::insertControlPoint(std::vector<glm::vec3> &controlPoints,
+                                        std::vector<glm::vec3> &samples,
+                                        const size_t i,
+                                        const glm::vec3 &point) const
+{
+    bool incremental = this->incremental(controlPoints.size(),
+                                         samples.size());
+
+    controlPoints.insert(controlPoints.begin() + i, point);
+
+    if (!incremental)
+        return this->retessellate(controlPoints, samples);
+
+    size_t segmentSamples = this->curve.getSegmentSamples();
+    size_t segments = controlPoints.size() - 3;
+
+    // a segment before the former segment i, evaluated below
+    samples.insert(samples.begin() +
+                   std::min(i, segments - 1) * segmentSamples,
+                   segmentSamples, glm::vec3());
+
+    return this->evaluateSegments(controlPoints, i < 3 ? 0 : i - 3,
+                                  std::min(i + 1, segments), true, samples);
+}
+
+SampleRange Sweeper::eraseControlPoint(std::vector<glm::vec3> &controlPoints,
+                                       std::vector<glm::vec3> &samples,
+                                       const size_t i) const
+{
+    bool incremental = this->incremental(controlPoints.size(),
+                                         samples.size());
+
+    controlPoints.erase(controlPoints.begin() + i);
+
+    if (!incremental || controlPoints.size() < 4)
+        return this->retessellate(controlPoints, samples);
+
+    size_t segmentSamples = this->curve.getSegmentSamples();
+    size_t segments = controlPoints.size() - 3;
+
+    // the former segment i, or the last one
+    samples.erase(samples.begin() + std::min(i, segments) * segmentSamples,
+                  samples.begin() + (std::min(i, segments) + 1) *
+                                    segmentSamples);
+
+    return this->evaluateSegments(controlPoints, i < 3 ? 0 : i - 3,
+                                  std::min(i, segments), true, samples);
+}
+
+// vertices per parallel task
+static const size_t sweepGrain = 16384;
+// indices per parallel task
+static const size_t indicesGrain = 32768;
+
+void Sweeper::sweepTranslational(const std::vector<glm::vec3> &profile,
+                                 const std::vector<glm::vec3> &trajectory,
+                                 std::vector<glm::vec3> &vertices) const
+{
+    this->sweepTranslational(profile, NULL, trajectory, NULL,
+                             vertices, NULL);
+}
+
+void Sweeper::sweepTranslational(
+    const std::vector<glm::vec3> &profile,
+    const std::vector<glm::vec3> &profileTangents,
+    const std::vector<glm::vec3> &trajectory,
+    const std::vector<glm::vec3> &trajectoryTangents,
+    std::vector<glm::vec3> &vertices,
+    std::vector<glm::vec3> &normals) const
+{
+    this->sweepTranslational(profile, &profileTangents, trajectory,
+                             &trajectoryTangents, vertices, &normals);
+}
+
+void Sweeper::sweepTranslational(
+    const std::vector<glm::vec3> &profile,
+    const std::vector<glm::vec3> *profileTangents,
+    const std::vector<glm::vec3> &trajectory,
+    const std::vector<glm::vec3> *trajectoryTangents,
+    std::vector<glm::vec3> &vertices,
+    std::vector<glm::vec3> *normals) const
+{
+    size_t points = profile.size();
+
+    vertices.resize(points * (trajectory.size() + 1));
+    if (normals)
+        normals->resize(vertices.size());
+
+    if (vertices.empty())
+        return;
+
+    // the first profile curve is laid twice, at t_0
+    std::copy(profile.begin(), profile.end(), vertices.begin());
+
+    // for n translation <=> n new profile curves
+    this->forEach(0, trajectory.size(), sweepGrain / points + 1,
+                  [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            // translation vector from t_0 to t_i
+            glm::vec3 t(trajectory[i] - trajectory[0]);
+            glm::vec3 *polygon = &vertices[(i + 1) * points];
+
+            for (size_t p = 0; p < points; p++)
+                polygon[p] = profile[p] + t;
+
+            if (!normals)
+                continue;
+
+            // across the profile and along the trajectory
+            const glm::vec3 &sweep = (*trajectoryTangents)[i];
+            glm::vec3 *normal = &(*normals)[(i + 1) * points];
+
+            for (size_t p = 0; p < points; p++)
+                normal[p] = unit(glm::cross((*profileTangents)[p], sweep));
+            fillNormals(normal, points);
+
+            if (i == 0)
+                std::copy(normal, normal + points, &(*normals)[0]);
+        }
+    });
+}
+
+void Sweeper::sweepRotational(const std::vector<glm::vec3> &profile,
+                              const size_t spans,
+                              std::vector<glm::vec3> &vertices) const
+{
+    this->sweepRotational(profile, NULL, spans, vertices, NULL);
+}
+
+void Sweeper::sweepRotational(const std::vector<glm::vec3> &profile,
+                              const std::vector<glm::vec3> &profileTangents,
+                              const size_t spans,
+                              std::vector<glm::vec3> &vertices,
+                              std::vector<glm::vec3> &normals) const
+{
+    this->sweepRotational(profile, &profileTangents, spans,
+                          vertices, &normals);
+}
+
+void Sweeper::sweepRotational(const std::vector<glm::vec3> &profile,
+                              const std::vector<glm::vec3> *profileTangents,
+                              const size_t spans,
+                              std::vector<glm::vec3> &vertices,
+                              std::vector<glm::vec3> *normals) const
+{
+    size_t points = profile.size();
+
+    vertices.resize(points * (spans + 1));
+    if (normals)
+        normals->resize(vertices.size());
+
+    if (vertices.empty())
+        return;
+
+    // scratch: from the arena if any
+    std::vector<float> turnsHeap, soaHeap, normalsSoaHeap;
+    std::vector<glm::vec3> profileNormalsHeap;
+
+    // cos / sin of every span, once; remove 2 pi for artsy shapes
+    float *turns = Arena::scratch(this->arena, 2 * (spans + 1), turnsHeap);
+    for (size_t s = 0; s <= spans; s++)
+    {
+        double angle = (2 * M_PI * s) / spans;
+        turns[2 * s] = cos(angle);
+        turns[2 * s + 1] = sin(angle);
+    }
+
+    // AoS -> SoA
+    float *x = Arena::scratch(this->arena, 3 * points, soaHeap);
+    float *y = x + points;
+    float *z = y + points;
+
+    for (size_t p = 0; p < points; p++)
+    {
+        x[p] = profile[p].x;
+        y[p] = profile[p].y;
+        z[p] = profile[p].z;
+    }
+
+    // the normals of the profile, in the span 0, rotated alike
+    glm::vec3 *profileNormals = NULL;
+    float *normalsSoa = NULL;
+    if (normals)
+    {
+        profileNormals = Arena::scratch(this->arena, points,
+                                        profileNormalsHeap);
+        for (size_t p = 0; p < points; p++)
+        {
+            // d/dangle of the point: z x p
+            glm::vec3 turn(-profile[p].y, profile[p].x, 0.0f);
+            profileNormals[p] = unit(glm::cross((*profileTangents)[p],
+                                                turn));
+        }
+        fillNormals(profileNormals, points);
+
+        normalsSoa = Arena::scratch(this->arena, 3 * points,
+                                    normalsSoaHeap);
+        for (size_t p = 0; p < points; p++)
+        {
+            // on the axis, facing as the closest normal off the axis
+            if (profile[p].x == 0 && profile[p].y == 0)
+                profileNormals[p] = glm::vec3(
+                    0.0f, 0.0f, (profileNormals[p].z < 0) ? -1.0f : 1.0f);
+
+            normalsSoa[p] = profileNormals[p].x;
+            normalsSoa[points + p] = profileNormals[p].y;
+            normalsSoa[2 * points + p] = profileNormals[p].z;
+        }
+    }
+
+    RotateFunction rotate = rotateFunction(this->curve.getKernel());
+
+    this->forEach(0, spans + 1, sweepGrain / points + 1,
+                  [&](size_t begin, size_t end)
+    {
+        // rotateCurve, each span straight from the profile curve
+        for (size_t s = begin; s < end; s++)
+        {
+            glm::vec3 *polygon = &vertices[s * points];
+
+            // seam: the last span lands exactly on the first one
+            if (s == 0 || s == spans)
+                std::copy(profile.begin(), profile.end(), polygon);
+            else
+                rotate(x, y, z, points, turns[2 * s], turns[2 * s + 1],
+                       polygon);
+
+            if (!normals)
+                continue;
+
+            glm::vec3 *normal = &(*normals)[s * points];
+            const float *n = normalsSoa;
+
+            if (s == 0 || s == spans)
+                std::copy(profileNormals, profileNormals + points, normal);
+            else
+                rotate(n, n + points, n + 2 * points, points,
+                       turns[2 * s], turns[2 * s + 1], normal);
+        }
+    });
+}
+
+void Sweeper::resweepProfile(const DataModel::SweepType sweepType,
+                             const std::vector<glm::vec3> &profile,
+                             const std::vector<glm::vec3> &trajectory,
+                             const size_t spans, const SampleRange &changed,
+                             std::vector<glm::vec3> &vertices) const
+{
+    size_t points = profile.size();
+    size_t begin = changed.begin;
+    size_t count = std::min(changed.end, points) - begin;
+    bool rotational = (sweepType == DataModel::SweepType::Rotational);
+    size_t copies = rotational ? spans + 1 : trajectory.size() + 1;
+
+    if (changed.begin >= changed.end || vertices.size() != points * copies)
+        return;
+
+    // AoS -> SoA, the changed samples only
+    std::vector<float> soaHeap;
+    float *x = Arena::scratch(this->arena, 3 * count, soaHeap);
+    float *y = x + count;
+    float *z = y + count;
+
+    for (size_t p = 0; p < count; p++)
+    {
+        x[p] = profile[begin + p].x;
+        y[p] = profile[begin + p].y;
+        z[p] = profile[begin + p].z;
+    }
+
+    RotateFunction rotate = rotateFunction(this->curve.getKernel());
+
+    this->forEach(0, copies, sweepGrain / count + 1,
+                  [&](size_t first, size_t last)
+    {
+        for (size_t s = first; s < last; s++)
+        {
+            glm::vec3 *polygon = &vertices[s * points + begin];
+
+            // as sweepRotational and sweepTranslational
+            if (s == 0 || (rotational && s == spans))
+            {
+                std::copy(profile.begin() + begin,
+                          profile.begin() + begin + count, polygon);
+            }
+            else if (rotational)
+            {
+                double angle = (2 * M_PI * s) / spans;
+                rotate(x, y, z, count, cos(angle), sin(angle), polygon);
+            }
+            else
+            {
+                glm::vec3 t(trajectory[s - 1] - trajectory[0]);
+
+                for (size_t p = 0; p < count; p++)
+                    polygon[p] = profile[begin + p] + t;
+            }
+        }
+    });
+}
+
+void Sweeper::resweepTrajectory(const std::vector<glm::vec3> &profile,
+                                const std::vector<glm::vec3> &trajectory,
+                                const SampleRange &changed,
+                                std::vector<glm::vec3> &vertices) const
+{
+    size_t points = profile.size();
+
+    if (changed.begin >= changed.end ||
+        vertices.size() != points * (trajectory.size() + 1))
+        return;
+
+    // every copy is relative to t_0
+    size_t last = (changed.begin == 0) ? trajectory.size() :
+                  std::min(changed.end, trajectory.size());
+
+    this->forEach(changed.begin, last, sweepGrain / points + 1,
+                  [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            glm::vec3 t(trajectory[i] - trajectory[0]);
+            glm::vec3 *polygon = &vertices[(i + 1) * points];
+
+            for (size_t p = 0; p < points; p++)
+                polygon[p] = profile[p] + t;
+        }
+    });
+}
+
+void Sweeper::sweepTransforms(const DataModel::SweepType sweepType,
+                              const std::vector<glm::vec3> &trajectory,
+                              const size_t spans,
+                              std::vector<glm::vec4> &transforms) const
+{
+    transforms.clear();
+
+    if (sweepType == DataModel::SweepType::Rotational)
+    {
+        if (spans == 0)
+            return;
+
+        transforms.resize(spans + 1);
+        for (size_t s = 0; s <= spans; s++)
+        {
+            double angle = (2 * M_PI * s) / spans;
+            transforms[s] = glm::vec4(cos(angle), sin(angle), 0, 0);
+        }
+        // seam: as sweepRotational, exact profile copies
+        transforms[0] = transforms[spans] = glm::vec4(1, 0, 0, 0);
+        return;
+    }
+
+    if (trajectory.empty())
+        return;
+
+    // the first profile curve is laid twice, at t_0
+    transforms.resize(trajectory.size() + 1);
+    transforms[0] = glm::vec4(0);
+    for (size_t t = 0; t < trajectory.size(); t++)
+        transforms[t + 1] = glm::vec4(trajectory[t] - trajectory[0], 0);
+}
+
+// quads of rows [first, last) of a profileSize wide grid, each
+// indexed relative to the first row of its meshlet
+template <typename T>
+static void genQuadsIndices(const size_t profileSize,
+                            const size_t first, const size_t last,
+                            const size_t meshletRows, T *indices)
+{
+    T p1, p2;
+
+    indices += first * (profileSize - 1) * 6;
+
+    for (size_t s = first; s < last; s++)
+    {
+        size_t row = s % meshletRows;
+
+        for (size_t p = 0; p < profileSize - 1; p++)
+        {
+            p1 = p + profileSize * row;
+            p2 = p + profileSize * (row + 1);
+
+            // Triangle 1
+            *indices++ = p1;
+            *indices++ = p1 + 1;
+            *indices++ = p2;
+
+            // Triangle 2
+            *indices++ = p1 + 1;
+            *indices++ = p2;
+            *indices++ = p2 + 1;
+        }
+    }
+}
+
+// same rows as one strip each, same diagonals as the quads
+template <typename T>
+static void genStripsIndices(const size_t profileSize,
+                             const size_t first, const size_t last,
+                             const size_t meshletRows, const T restart,
+                             T *indices)
+{
+    indices += first * (2 * profileSize + 1);
+
+    for (size_t s = first; s < last; s++)
+    {
+        size_t row = s % meshletRows;
+
+        for (size_t p = 0; p < profileSize; p++)
+        {
+            *indices++ = p + profileSize * row;
+            *indices++ = p + profileSize * (row + 1);
+        }
+        *indices++ = restart;
+    }
+}
+
+void Sweeper::genIndices(const size_t profileSize, const size_t sweeps,
+                         IndexBuffer &indices) const
+{
+    indices.clear();
+    indices.setTopology(this->topology);
+
+    if (profileSize < 2 || sweeps == 0)
+        return;
+
+    bool strips = (this->topology == IndexBuffer::Topology::TriangleStrip);
+
+    size_t vertices = profileSize * (sweeps + 1);
+    size_t rowIndices = strips ?
+        2 * profileSize + 1 : (profileSize - 1) * 6;
+    // 16 bits strips keep 0xFFFF for restarts
+    size_t maxVertices = strips ? 65535 : 65536;
+    size_t meshletVertices = std::min(this->meshletVertices, maxVertices);
+    // sweeps per meshlet
+    size_t rows = sweeps;
+
+    if (meshletVertices && vertices > meshletVertices &&
+        2 * profileSize <= meshletVertices)
+    {
+        rows = meshletVertices / profileSize - 1;
+    }
+
+    IndexBuffer::Width width = IndexBuffer::Width::U32;
+    if (rows < sweeps || vertices <= maxVertices)
+        width = IndexBuffer::Width::U16;
+
+    indices.resize(width, sweeps * rowIndices);
+
+    for (size_t s = 0; s < sweeps; s += rows)
+    {
+        Meshlet meshlet;
+        meshlet.baseVertex = s * profileSize;
+        meshlet.firstIndex = s * rowIndices;
+        meshlet.indexCount = std::min(rows, sweeps - s) * rowIndices;
+        indices.meshlets.push_back(meshlet);
+    }
+
+    // translational & rotational
+    this->forEach(0, sweeps, indicesGrain / rowIndices + 1,
+                  [&](size_t begin, size_t end)
+    {
+        if (strips && width == IndexBuffer::Width::U16)
+            genStripsIndices<uint16_t>(profileSize, begin, end, rows,
+                                       indices.restartIndex(), indices.u16());
+        else if (strips)
+            genStripsIndices<uint32_t>(profileSize, begin, end, rows,
+                                       indices.restartIndex(), indices.u32());
+        else if (width == IndexBuffer::Width::U16)
+            genQuadsIndices(profileSize, begin, end, rows, indices.u16());
+        else
+            genQuadsIndices(profileSize, begin, end, rows, indices.u32());
+    });
+}
@@ -0,0 +1,216 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Sweeps tessellated curves into a surface (no OpenGL)
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "DataModel.hpp"
+#include "CatmullRom.hpp"
+#include "IndexBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "Arena.hpp"
+
+struct SweepMesh
+{
+    // tessellated curves
+    std::vector<glm::vec3> profile;
+    std::vector<glm::vec3> trajectory;
+    // their derivatives, with normals only
+    std::vector<glm::vec3> profileTangents;
+    std::vector<glm::vec3> trajectoryTangents;
+    // swept surface, one profile copy per sweep + 1
+    std::vector<glm::vec3> vertices;
+    // one per vertex, unit length, empty unless asked for
+    std::vector<glm::vec3> normals;
+    IndexBuffer indices;
+    size_t sweeps = 0;
+};
+
+// samples [begin, end) changed, the ones past end moved if resized
+struct SampleRange
+{
+    size_t begin;
+    size_t end;
+    bool resized;
+};
+
+/*
+ * Stateless once configured: a single instance can be shared
+ * by any number of threads. Every sweep and row of indices is
+ * computed on its own, in parallel when given a thread pool,
+ * with the same output either way. Given an arena, its scratch
+ * is taken on the calling thread before any parallel work, so
+ * such an instance must not be called from two threads at once.
+*/
+class Sweeper
+{
+    public:
+        Sweeper();
+        Sweeper(const CatmullRom &curve);
+        ~Sweeper();
+
+        const CatmullRom& getCurve() const;
+
+        /*
+         * Splits the surface in meshlets of at most that many vertices
+         * (<= 65536) indexed with 16 bits each; 0 keeps a single range,
+         * 16 bits wide only if the whole surface fits.
+        */
+        size_t getMeshletVertices() const;
+        void setMeshletVertices(const size_t vertices);
+
+        // strips: one per sweep, about a third of the list indices
+        IndexBuffer::Topology getTopology() const;
+        void setTopology(const IndexBuffer::Topology topology);
+
+        // analytic, from the curve derivatives, see sweepRotational
+        bool getNormals() const;
+        void setNormals(const bool normals);
+
+        /*
+         * Not owned, the scratch memory of the calls (SoA copies, turns)
+         * taken from it instead of the heap, for the caller to reset
+         * between regenerations; NULL for the heap.
+        */
+        Arena* getArena() const;
+        void setArena(Arena *arena);
+
+        // not owned, NULL sweeps on the calling thread only
+        ThreadPool* getThreadPool() const;
+        void setThreadPool(ThreadPool *pool);
+
+        // control points -> curves -> swept vertices -> indices
+        bool sweep(const DataModel &dataModel, SweepMesh &mesh) const;
+        // straight from memory owned by someone else, e.g. a ModelFile
+        bool sweep(const DataModel::SweepType sweepType, const size_t spans,
+                   const glm::vec3 *profile, const size_t profilePoints,
+                   const glm::vec3 *trajectory, const size_t trajectoryPoints,
+                   SweepMesh &mesh) const;
+
+        void tessellate(const std::vector<glm::vec3> &controlPoints,
+                        std::vector<glm::vec3> &samples) const;
+        void tessellate(const glm::vec3 *controlPoints, const size_t points,
+                        std::vector<glm::vec3> &samples) const;
+        // with the curve derivative at every sample
+        void tessellate(const std::vector<glm::vec3> &controlPoints,
+                        std::vector<glm::vec3> &samples,
+                        std::vector<glm::vec3> &tangents) const;
+        void tessellate(const glm::vec3 *controlPoints, const size_t points,
+                        std::vector<glm::vec3> &samples,
+                        std::vector<glm::vec3> &tangents) const;
+
+        /*
+         * Edits control point i of a curve tessellated into samples and
+         * evaluates again the up to 4 segments it weighs on, the other
+         * samples being kept or moved; the whole curve is tessellated
+         * with adaptive subdivision or less than 4 points.
+        */
+        SampleRange moveControlPoint(std::vector<glm::vec3> &controlPoints,
+                                     std::vector<glm::vec3> &samples,
+                                     const size_t i,
+                                     const glm::vec3 &point) const;
+        // before point i, appended if i is the size
+        SampleRange insertControlPoint(std::vector<glm::vec3> &controlPoints,
+                                       std::vector<glm::vec3> &samples,
+                                       const size_t i,
+                                       const glm::vec3 &point) const;
+        SampleRange eraseControlPoint(std::vector<glm::vec3> &controlPoints,
+                                      std::vector<glm::vec3> &samples,
+                                      const size_t i) const;
+
+        void sweepTranslational(const std::vector<glm::vec3> &profile,
+                                const std::vector<glm::vec3> &trajectory,
+                                std::vector<glm::vec3> &vertices) const;
+
+        void sweepRotational(const std::vector<glm::vec3> &profile,
+                             const size_t spans,
+                             std::vector<glm::vec3> &vertices) const;
+
+        /*
+         * And the normals of the vertices, in the same pass: the cross
+         * product of the profile tangent and of the sweep direction, the
+         * trajectory tangent or the turn about z of the profile point,
+         * whose normals are rotated along with it. Points on the axis
+         * get the axis, others where it vanishes the closest normal.
+        */
+        void sweepTranslational(const std::vector<glm::vec3> &profile,
+                                const std::vector<glm::vec3> &profileTangents,
+                                const std::vector<glm::vec3> &trajectory,
+                                const std::vector<glm::vec3> &trajectoryTangents,
+                                std::vector<glm::vec3> &vertices,
+                                std::vector<glm::vec3> &normals) const;
+        void sweepRotational(const std::vector<glm::vec3> &profile,
+                             const std::vector<glm::vec3> &profileTangents,
+                             const size_t spans,
+                             std::vector<glm::vec3> &vertices,
+                             std::vector<glm::vec3> &normals) const;
+
+        /*
+         * Updates the vertices of a previous sweep, same sizes, after
+         * the profile (resp. trajectory) samples in changed moved: in
+         * every profile copy (resp. the copies laid along them).
+        */
+        void resweepProfile(const DataModel::SweepType sweepType,
+                            const std::vector<glm::vec3> &profile,
+                            const std::vector<glm::vec3> &trajectory,
+                            const size_t spans, const SampleRange &changed,
+                            std::vector<glm::vec3> &vertices) const;
+        void resweepTrajectory(const std::vector<glm::vec3> &profile,
+                               const std::vector<glm::vec3> &trajectory,
+                               const SampleRange &changed,
+                               std::vector<glm::vec3> &vertices) const;
+
+        void genIndices(const size_t profileSize, const size_t sweeps,
+                        IndexBuffer &indices) const;
+
+        /*
+         * One transform per profile copy instead of the copies, for the
+         * surface to be swept on the gpu: (cos, sin, 0, 0) of the turn
+         * around z when rotational, the (x, y, z, 0) offset otherwise.
+        */
+        void sweepTransforms(const DataModel::SweepType sweepType,
+                             const std::vector<glm::vec3> &trajectory,
+                             const size_t spans,
+                             std::vector<glm::vec4> &transforms) const;
+
+    private:
+        // normals too unless NULL
+        void sweepTranslational(const std::vector<glm::vec3> &profile,
+                                const std::vector<glm::vec3> *profileTangents,
+                                const std::vector<glm::vec3> &trajectory,
+                                const std::vector<glm::vec3> *trajectoryTangents,
+                                std::vector<glm::vec3> &vertices,
+                                std::vector<glm::vec3> *normals) const;
+        void sweepRotational(const std::vector<glm::vec3> &profile,
+                             const std::vector<glm::vec3> *profileTangents,
+                             const size_t spans,
+                             std::vector<glm::vec3> &vertices,
+                             std::vector<glm::vec3> *normals) const;
+
+        bool incremental(const size_t controlPoints,
+                         const size_t samples) const;
+        SampleRange retessellate(const std::vector<glm::vec3> &controlPoints,
+                                 std::vector<glm::vec3> &samples) const;
+        SampleRange evaluateSegments(
+            const std::vector<glm::vec3> &controlPoints,
+            const size_t first, const size_t last, const bool resized,
+            std::vector<glm::vec3> &samples) const;
+
+        void forEach(const size_t begin, const size_t end, const size_t grain,
+                     const ThreadPool::RangeTask &task) const;
+
+        CatmullRom curve;
+        size_t meshletVertices = 0;
+        IndexBuffer::Topology topology = IndexBuffer::Topology::Triangles;
+        bool normals = false;
+        ThreadPool *pool = NULL;
+        Arena *arena = NULL;
+};
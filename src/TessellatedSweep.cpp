@@ -0,0 +1,158 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "TessellatedSweep.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "FrameUniforms.hpp"
+
+// texture units of the buffers
+static const GLint profileUnit = 0;
+static const GLint trajectoryUnit = 1;
+
+TessellatedSweep::TessellatedSweep(const float tension) :
+    profileBuffer(GL_TEXTURE_BUFFER),
+    trajectoryBuffer(GL_TEXTURE_BUFFER),
+    viewport(0.0f)
+{
+    this->shader = Shader::acquire(
+        "src/shaders/tess.vs",
+        "src/shaders/sweep.tcs",
+        "src/shaders/sweep.tes",
+        "src/shaders/default.fs");
+
+    this->modelLoc = this->shader->getUniformLocation("model");
+    this->viewportLoc = this->shader->getUniformLocation("viewport");
+    this->segmentsLoc = this->shader->getUniformLocation("segments");
+    this->bandsLoc = this->shader->getUniformLocation("bands");
+    this->rotationalLoc = this->shader->getUniformLocation("rotational");
+    this->edgePixelsLoc = this->shader->getUniformLocation("edgePixels");
+    this->shader->bindUniformBlock(FrameUniforms::blockName(),
+                                   FrameUniforms::binding);
+
+    this->shader->use();
+    glUniform1i(this->shader->getUniformLocation("profile"), profileUnit);
+    glUniform1i(this->shader->getUniformLocation("trajectory"),
+                trajectoryUnit);
+    glUniform1f(this->shader->getUniformLocation("tension"), tension);
+    glUniform1f(this->shader->getUniformLocation("maxLevel"),
+                TessellatedSweep::maxLevel);
+    glUniform1i(this->shader->getUniformLocation("colorize"), 1);
+    glUseProgram(0);
+
+    this->setEdgePixels(8.0f);
+
+    glGenVertexArrays(1, &this->vaoId);
+    glGenTextures(1, &this->profileTexture);
+    glGenTextures(1, &this->trajectoryTexture);
+}
+
+TessellatedSweep::~TessellatedSweep()
+{
+    glDeleteTextures(1, &this->trajectoryTexture);
+    glDeleteTextures(1, &this->profileTexture);
+    glDeleteVertexArrays(1, &this->vaoId);
+    Shader::release(this->shader);
+}
+
+// texel aligned copy, the texture follows its buffer storage
+static void uploadPoints(const std::vector<glm::vec3> &points,
+                         std::vector<glm::vec4> &texels,
+                         GpuBuffer &buffer, const GLuint texture)
+{
+    texels.resize(points.size());
+    for (size_t p = 0; p < points.size(); p++)
+        texels[p] = glm::vec4(points[p], 0);
+
+    buffer.invalidate();
+    buffer.upload(texels.empty() ? NULL : &texels[0],
+                  sizeof(glm::vec4) * texels.size());
+
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer.getId());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+bool TessellatedSweep::upload(const DataModel::SweepType sweepType,
+                              const std::vector<glm::vec3> &profile,
+                              const std::vector<glm::vec3> &trajectory,
+                              const uint32_t spans)
+{
+    bool rotational = (sweepType == DataModel::SweepType::Rotational);
+    size_t segments = profile.size() < 4 ? 0 : profile.size() - 3;
+    size_t bands = rotational ? spans :
+                   (trajectory.size() < 4 ? 0 : trajectory.size() - 3);
+
+    this->patches = segments * bands;
+    if (this->patches == 0)
+        return false;
+
+    uploadPoints(profile, this->texels,
+                 this->profileBuffer, this->profileTexture);
+    if (!rotational)
+        uploadPoints(trajectory, this->texels,
+                     this->trajectoryBuffer, this->trajectoryTexture);
+
+    this->shader->use();
+    glUniform1i(this->segmentsLoc, segments);
+    glUniform1i(this->bandsLoc, bands);
+    glUniform1i(this->rotationalLoc, rotational);
+    glUseProgram(0);
+    return true;
+}
+
+void TessellatedSweep::setModel(const glm::mat4 &model)
+{
+    this->shader->use();
+    glUniformMatrix4fv(this->modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+}
+
+void TessellatedSweep::setEdgePixels(const float pixels)
+{
+    this->shader->use();
+    glUniform1f(this->edgePixelsLoc, pixels);
+}
+
+void TessellatedSweep::draw(const GLenum renderMode,
+                            const glm::vec2 &viewport,
+                            DrawStats &stats)
+{
+    stats = DrawStats();
+
+    if (this->patches == 0)
+        return;
+
+    this->shader->use();
+
+    if (viewport != this->viewport)
+    {
+        glUniform2f(this->viewportLoc, viewport.x, viewport.y);
+        this->viewport = viewport;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + profileUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, this->profileTexture);
+    glActiveTexture(GL_TEXTURE0 + trajectoryUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, this->trajectoryTexture);
+
+    // the evaluation shader emits triangles only
+    if (renderMode == GL_POINTS)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+
+    glBindVertexArray(this->vaoId);
+    glPatchParameteri(GL_PATCH_VERTICES, 1);
+    glDrawArrays(GL_PATCHES, 0, this->patches);
+    glBindVertexArray(0);
+
+    if (renderMode == GL_POINTS)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    glActiveTexture(GL_TEXTURE0);
+
+    // the tessellated vertices are generated on the gpu, never counted
+    stats.drawCalls = 1;
+    stats.vertices = this->patches;
+}
@@ -0,0 +1,61 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Sweep surface evaluated by the tessellation stages (GL 4.0)
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "Shader.hpp"
+#include "GpuBuffer.hpp"
+#include "DataModel.hpp"
+#include "FrameProfiler.hpp"
+
+/*
+ * Holds the control points only and draws one patch per profile
+ * segment and sweep band. The control shader picks the tessellation
+ * levels from the projected size of every patch edge, so the surface
+ * refines as the camera gets closer with nothing evaluated on the cpu
+ * and nothing uploaded again.
+*/
+class TessellatedSweep
+{
+    public:
+        // 64 on every conforming implementation
+        static const int maxLevel = 64;
+
+        TessellatedSweep(const float tension);
+        ~TessellatedSweep();
+
+        // false with less than 4 profile (or trajectory) points
+        bool upload(const DataModel::SweepType sweepType,
+                    const std::vector<glm::vec3> &profile,
+                    const std::vector<glm::vec3> &trajectory,
+                    const uint32_t spans);
+
+        void setModel(const glm::mat4 &model);
+        // target length of a tessellated edge on screen
+        void setEdgePixels(const float pixels);
+
+        // GL_POINTS draws the tessellated vertices
+        void draw(const GLenum renderMode, const glm::vec2 &viewport,
+                  DrawStats &stats);
+
+    private:
+        Shader *shader;
+        GLint modelLoc, viewportLoc;
+        GLint segmentsLoc, bandsLoc, rotationalLoc, edgePixelsLoc;
+        // attribute-less, patches come from gl_PrimitiveID
+        GLuint vaoId;
+        GpuBuffer profileBuffer, trajectoryBuffer;
+        GLuint profileTexture, trajectoryTexture;
+        std::vector<glm::vec4> texels;
+        glm::vec2 viewport;
+        size_t patches = 0;
+};
@@ -0,0 +1,175 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threads) :
+    queued(0),
+    nextQueue(0),
+    stop(false)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    // the thread calling parallelFor counts as one
+    for (unsigned int i = 0; i < threads; i++)
+        this->queues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+    for (unsigned int i = 0; i + 1 < threads; i++)
+        this->workers.push_back(std::thread(&ThreadPool::work, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->wake.notify_all();
+
+    for (auto &worker: this->workers)
+        worker.join();
+}
+
+unsigned int ThreadPool::size() const
+{
+    return this->queues.size();
+}
+
+void ThreadPool::parallelFor(const size_t begin, const size_t end,
+                             const size_t grain, const RangeTask &task)
+{
+    if (begin >= end)
+        return;
+
+    size_t step = grain ? grain : 1;
+    size_t ranges = (end - begin + step - 1) / step;
+
+    if (ranges == 1 || this->workers.empty())
+    {
+        task(begin, end);
+        return;
+    }
+
+    Job job;
+    job.task = &task;
+    job.pending = ranges;
+
+    // counted first so that a quick worker never takes it below 0
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->queued += ranges;
+    }
+
+    // deal ranges round robin, neighbours end up on different queues
+    unsigned int q = this->nextQueue++;
+    for (size_t b = begin; b < end; b += step)
+    {
+        Range range = {&job, b, std::min(b + step, end)};
+        Queue &queue = *this->queues[q++ % this->queues.size()];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.pushBack(range);
+    }
+    this->wake.notify_all();
+
+    // help instead of sleeping, any job's ranges will do
+    Range range;
+    while (job.pending > 0 && this->pop(this->queues.size() - 1, range))
+        this->run(range);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [&job]() { return job.pending == 0; });
+}
+
+void ThreadPool::work(const unsigned int id)
+{
+    Range range;
+
+    while (true)
+    {
+        if (this->pop(id, range))
+        {
+            this->run(range);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->wake.wait(lock, [this]() {
+            return this->stop || this->queued > 0;
+        });
+        if (this->stop)
+            return;
+    }
+}
+
+bool ThreadPool::pop(const unsigned int id, Range &range)
+{
+    size_t queues = this->queues.size();
+
+    // own queue from the front, then steal from the back of the others
+    for (size_t i = 0; i < queues; i++)
+    {
+        Queue &queue = *this->queues[(id + i) % queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.count == 0)
+            continue;
+
+        if (i == 0)
+            range = queue.popFront();
+        else
+            range = queue.popBack();
+        this->queued--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(const Range &range)
+{
+    Job *job = range.job;
+
+    (*job->task)(range.begin, range.end);
+
+    if (--job->pending == 0)
+    {
+        // the waiter may be about to sleep on it
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->done.notify_all();
+    }
+}
+
+void ThreadPool::Queue::pushBack(const Range &range)
+{
+    if (this->count == this->ranges.size())
+    {
+        // unrolled from the head into twice the size
+        std::vector<Range> grown(std::max(2 * this->count, (size_t) 16));
+        for (size_t i = 0; i < this->count; i++)
+            grown[i] = this->ranges[(this->head + i) % this->ranges.size()];
+        this->ranges.swap(grown);
+        this->head = 0;
+    }
+    this->ranges[(this->head + this->count++) % this->ranges.size()] = range;
+}
+
+ThreadPool::Range ThreadPool::Queue::popFront()
+{
+    Range range = this->ranges[this->head];
+    this->head = (this->head + 1) % this->ranges.size();
+    this->count--;
+    return range;
+}
+
+ThreadPool::Range ThreadPool::Queue::popBack()
+{
+    this->count--;
+    return this->ranges[(this->head + this->count) % this->ranges.size()];
+}
@@ -0,0 +1,104 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Persistent work-stealing pool running ranges of a loop
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+    public:
+        /*
+         * Any callable of (begin, end), referenced rather than copied
+         * into a std::function, which would allocate for most lambdas:
+         * it has to outlive the call, as a lambda argument does.
+        */
+        class RangeTask
+        {
+            public:
+                template <typename Function>
+                RangeTask(const Function &function) :
+                    function(&function),
+                    call([](const void *f, size_t begin, size_t end)
+                         { (*(const Function*) f)(begin, end); })
+                {
+                }
+
+                void operator()(const size_t begin, const size_t end) const
+                {
+                    this->call(this->function, begin, end);
+                }
+
+            private:
+                const void *function;
+                void (*call)(const void *function,
+                             size_t begin, size_t end);
+        };
+
+        // 0 threads: one per hardware thread
+        ThreadPool(unsigned int threads = 0);
+        ~ThreadPool();
+
+        // workers + the calling thread
+        unsigned int size() const;
+
+        /*
+         * Runs task over [begin, end) cut in ranges of grain elements and
+         * returns once all are done; the caller works too. Safe to call
+         * from several threads at once.
+        */
+        void parallelFor(const size_t begin, const size_t end,
+                         const size_t grain, const RangeTask &task);
+
+    private:
+        struct Job
+        {
+            const RangeTask *task;
+            std::atomic<size_t> pending;
+        };
+
+        struct Range
+        {
+            Job *job;
+            size_t begin;
+            size_t end;
+        };
+
+        // ring of ranges, grown when full and never shrunk
+        struct Queue
+        {
+            std::mutex mutex;
+            std::vector<Range> ranges;
+            size_t head = 0;
+            size_t count = 0;
+
+            void pushBack(const Range &range);
+            Range popFront();
+            Range popBack();
+        };
+
+        void work(const unsigned int id);
+        bool pop(const unsigned int id, Range &range);
+        void run(const Range &range);
+
+        std::vector<std::thread> workers;
+        // one per worker, last one fed by callers
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::atomic<size_t> queued;
+        std::atomic<unsigned int> nextQueue;
+        bool stop;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+};
@@ -0,0 +1,219 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+*/
+
+#include "Welder.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+struct WeldKey
+{
+    int64_t x, y, z;
+    uint32_t index;
+
+    bool operator<(const WeldKey &k) const
+    {
+        if (x != k.x) return x < k.x;
+        if (y != k.y) return y < k.y;
+        if (z != k.z) return z < k.z;
+        return index < k.index;
+    }
+
+    bool sameCell(const WeldKey &k) const
+    {
+        return x == k.x && y == k.y && z == k.z;
+    }
+};
+
+Welder::Welder(const float epsilon) :
+    epsilon(epsilon)
+{
+}
+
+Welder::~Welder()
+{
+}
+
+float Welder::getEpsilon() const
+{
+    return this->epsilon;
+}
+
+WeldStats Welder::weldSweep(const DataModel::SweepType sweepType,
+                            const size_t profileSize,
+                            std::vector<glm::vec3> &vertices,
+                            IndexBuffer &indices) const
+{
+    std::vector<uint32_t> remap;
+    this->sweepRemap(sweepType, profileSize, vertices, remap);
+    return this->apply(remap, vertices, NULL, indices);
+}
+
+WeldStats Welder::weldSweep(const DataModel::SweepType sweepType,
+                            const size_t profileSize,
+                            std::vector<glm::vec3> &vertices,
+                            std::vector<glm::vec3> &normals,
+                            IndexBuffer &indices) const
+{
+    std::vector<uint32_t> remap;
+    this->sweepRemap(sweepType, profileSize, vertices, remap);
+    return this->apply(remap, vertices, &normals, indices);
+}
+
+void Welder::sweepRemap(const DataModel::SweepType sweepType,
+                        const size_t profileSize,
+                        const std::vector<glm::vec3> &vertices,
+                        std::vector<uint32_t> &remap) const
+{
+    size_t points = profileSize;
+
+    remap.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+        remap[i] = i;
+
+    if (points > 0 && vertices.size() >= 2 * points)
+    {
+        if (sweepType == DataModel::SweepType::Rotational)
+        {
+            size_t spans = vertices.size() / points - 1;
+
+            for (size_t p = 0; p < points; p++)
+            {
+                // the last span is the first one
+                remap[spans * points + p] = p;
+
+                // on the axis of rotation (z) for every span
+                const glm::vec3 &v = vertices[p];
+                if (v.x == 0 && v.y == 0)
+                {
+                    for (size_t s = 1; s < spans; s++)
+                        remap[s * points + p] = p;
+                }
+            }
+        }
+        else
+        {
+            // the first profile curve is there twice
+            for (size_t p = 0; p < points; p++)
+                remap[points + p] = p;
+        }
+    }
+}
+
+WeldStats Welder::weld(std::vector<glm::vec3> &vertices,
+                       IndexBuffer &indices) const
+{
+    std::vector<WeldKey> keys(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        WeldKey &key = keys[i];
+        const glm::vec3 &v = vertices[i];
+
+        if (this->epsilon > 0)
+        {
+            key.x = llroundf(v.x / this->epsilon);
+            key.y = llroundf(v.y / this->epsilon);
+            key.z = llroundf(v.z / this->epsilon);
+        }
+        else
+        {
+            // bit patterns, -0 folded onto 0
+            int32_t bits[3];
+            glm::vec3 u = v + glm::vec3(0.0f);
+            memcpy(bits, &u, sizeof(bits));
+            key.x = bits[0];
+            key.y = bits[1];
+            key.z = bits[2];
+        }
+        key.index = i;
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    // first of each cell has the lowest index
+    std::vector<uint32_t> remap(vertices.size());
+    for (size_t i = 0, first = 0; i < keys.size(); i++)
+    {
+        if (!keys[i].sameCell(keys[first]))
+            first = i;
+        remap[keys[i].index] = keys[first].index;
+    }
+    return this->apply(remap, vertices, NULL, indices);
+}
+
+WeldStats Welder::apply(const std::vector<uint32_t> &remap,
+                        std::vector<glm::vec3> &vertices,
+                        std::vector<glm::vec3> *normals,
+                        IndexBuffer &indices) const
+{
+    WeldStats stats;
+    stats.vertices = vertices.size();
+
+    std::vector<uint32_t> compact(vertices.size());
+    size_t kept = 0;
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        if (remap[i] == i)
+        {
+            compact[i] = kept;
+            if (normals)
+                (*normals)[kept] = (*normals)[i];
+            vertices[kept++] = vertices[i];
+        }
+        else
+        {
+            compact[i] = compact[remap[i]];
+        }
+    }
+    vertices.resize(kept);
+    if (normals)
+        normals->resize(kept);
+    stats.removedVertices = stats.vertices - kept;
+
+    std::vector<uint32_t> absolute;
+    indices.triangles(absolute);
+
+    std::vector<uint32_t> triangles;
+    triangles.reserve(absolute.size());
+
+    for (size_t i = 0; i + 2 < absolute.size(); i += 3)
+    {
+        uint32_t t[3] = {
+            compact[absolute[i]],
+            compact[absolute[i + 1]],
+            compact[absolute[i + 2]]
+        };
+
+        if (t[0] == t[1] || t[1] == t[2] || t[0] == t[2])
+        {
+            stats.removedTriangles++;
+            continue;
+        }
+        triangles.insert(triangles.end(), t, t + 3);
+    }
+
+    indices.clear();
+    indices.setTopology(IndexBuffer::Topology::Triangles);
+
+    if (kept <= 65536)
+    {
+        indices.resize(IndexBuffer::Width::U16, triangles.size());
+        std::copy(triangles.begin(), triangles.end(), indices.u16());
+    }
+    else
+    {
+        indices.resize(IndexBuffer::Width::U32, triangles.size());
+        std::copy(triangles.begin(), triangles.end(), indices.u32());
+    }
+
+    Meshlet meshlet = {0, 0, indices.size()};
+    indices.meshlets.push_back(meshlet);
+
+    return stats;
+}
@@ -0,0 +1,72 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Merges duplicate vertices of a swept mesh (no OpenGL)
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "DataModel.hpp"
+#include "IndexBuffer.hpp"
+
+struct WeldStats
+{
+    size_t vertices = 0;
+    size_t removedVertices = 0;
+    // collapsed onto an edge or a point by the weld
+    size_t removedTriangles = 0;
+};
+
+/*
+ * Leaves a single triangle list of absolute indices, 16 bits
+ * wide if the welded vertices fit.
+*/
+class Welder
+{
+    public:
+        Welder(const float epsilon = 0);
+        ~Welder();
+
+        float getEpsilon() const;
+
+        /*
+         * Exact by construction: the seam and the points on the
+         * axis of a rotational sweep, the profile curve laid twice
+         * at the start of a translational sweep.
+        */
+        WeldStats weldSweep(const DataModel::SweepType sweepType,
+                            const size_t profileSize,
+                            std::vector<glm::vec3> &vertices,
+                            IndexBuffer &indices) const;
+
+        // the normals of the vertices following them
+        WeldStats weldSweep(const DataModel::SweepType sweepType,
+                            const size_t profileSize,
+                            std::vector<glm::vec3> &vertices,
+                            std::vector<glm::vec3> &normals,
+                            IndexBuffer &indices) const;
+
+        // any mesh: vertices in the same epsilon cell, exact if 0
+        WeldStats weld(std::vector<glm::vec3> &vertices,
+                       IndexBuffer &indices) const;
+
+    private:
+        // remap[i] <= i is the vertex that i merges into
+        WeldStats apply(const std::vector<uint32_t> &remap,
+                        std::vector<glm::vec3> &vertices,
+                        std::vector<glm::vec3> *normals,
+                        IndexBuffer &indices) const;
+        void sweepRemap(const DataModel::SweepType sweepType,
+                        const size_t profileSize,
+                        const std::vector<glm::vec3> &vertices,
+                        std::vector<uint32_t> &remap) const;
+
+        float epsilon;
+};
@@ -16,8 +16,10 @@
 class Window
 {
     public:
+        // core profile of at least the requested OpenGL version
         Window(const int w, const int h,
-               const char* title);
+               const char* title,
+               const int glMajor = 3, const int glMinor = 3);
         ~Window();
 
         GLFWwindow* get() const;
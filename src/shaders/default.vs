@@ -4,8 +4,13 @@ layout (location = 0) in vec3 position;
 out vec3 pos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// shared by every mesh, see FrameUniforms
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec3 pos;
+in vec3 viewNormal;
+out vec4 color;
+
+void main()
+{
+    // a light at the eye, both sides of the surface lit alike
+    float diffuse = abs(normalize(viewNormal).z);
+    vec3 albedo = vec3(abs(pos.x), abs(pos.y), abs(pos.z));
+
+    color = vec4(albedo * (0.25f + 0.75f * diffuse), 1.0f);
+}
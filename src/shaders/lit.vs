@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+// interleaved with the positions, see Spline::setLit
+layout (location = 1) in vec3 normal;
+
+out vec3 pos;
+out vec3 viewNormal;
+
+uniform mat4 model;
+
+// shared by every mesh, see FrameUniforms
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+};
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+    gl_PointSize = 5.0;
+    pos = position;
+    // rotations and translations only, no inverse transpose needed
+    viewNormal = mat3(view * model) * normal;
+}
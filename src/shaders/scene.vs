@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+// per instance or per vertex, see Scene
+layout (location = 1) in uint modelIndex;
+
+out vec3 pos;
+
+// one mat4 of 4 texels per model
+uniform samplerBuffer models;
+
+// shared by every mesh, see FrameUniforms
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+};
+
+void main()
+{
+    int texel = int(modelIndex) * 4;
+    mat4 model = mat4(texelFetch(models, texel),
+                      texelFetch(models, texel + 1),
+                      texelFetch(models, texel + 2),
+                      texelFetch(models, texel + 3));
+
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+    gl_PointSize = 5.0;
+    pos = position;
+}
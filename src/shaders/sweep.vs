@@ -0,0 +1,34 @@
+#version 330 core
+
+// one triangle strip per instance, between profile copies i and i + 1
+uniform samplerBuffer profile;
+uniform samplerBuffer transforms;
+uniform bool rotational;
+
+out vec3 pos;
+
+uniform mat4 model;
+
+// shared by every mesh, see FrameUniforms
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+};
+
+void main()
+{
+    vec3 p = texelFetch(profile, gl_VertexID / 2).xyz;
+    vec4 t = texelFetch(transforms, gl_InstanceID + gl_VertexID % 2);
+
+    // see Sweeper::sweepTransforms
+    vec3 position;
+    if (rotational)
+        position = vec3(p.x * t.x - p.y * t.y, p.x * t.y + p.y * t.x, p.z);
+    else
+        position = p + t.xyz;
+
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+    gl_PointSize = 5.0;
+    pos = position;
+}
@@ -0,0 +1,7 @@
+#version 400 core
+
+// one patch per vertex, the next stages only need gl_PrimitiveID
+void main()
+{
+    gl_Position = vec4(0.0f);
+}
@@ -0,0 +1,153 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief ModelFile::open against valid and corrupted files
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <functional>
+#include <string>
+
+#include "DataModel.hpp"
+#include "ModelFile.hpp"
+#include "Sweeper.hpp"
+
+static const char *validPath = "build/model-file-test.bin";
+static const char *corruptPath = "build/model-file-test.corrupt.bin";
+
+static size_t failures = 0;
+
+void check(const char *name, const bool passed)
+{
+    printf("%s: %s\n", passed ? "pass" : "FAIL", name);
+    if (!passed)
+        failures++;
+}
+
+bool readFile(const std::string &filename, std::string &content)
+{
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+
+    char chunk[4096];
+    size_t read;
+    content.clear();
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        content.append(chunk, read);
+    fclose(file);
+    return true;
+}
+
+bool writeFile(const std::string &filename, const std::string &content)
+{
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool written = fwrite(content.data(), 1, content.size(), file) ==
+                   content.size();
+    return (fclose(file) == 0) && written;
+}
+
+// a copy of the valid file, changed by corrupt, opened back
+bool opensCorrupted(const std::string &valid,
+                    const std::function<void(ModelFileHeader&,
+                                             ModelFileMeshlet*)> &corrupt)
+{
+    std::string content = valid;
+    ModelFileHeader *h = (ModelFileHeader*) &content[0];
+    corrupt(*h, (ModelFileMeshlet*) &content[h->meshletsOffset]);
+
+    ModelFile file;
+    return writeFile(corruptPath, content) && file.open(corruptPath);
+}
+
+int main()
+{
+    DataModel dataModel;
+    SweepMesh mesh;
+    Sweeper sweeper;
+    std::string valid;
+
+    dataModel.verbose = false;
+    dataModel.setSweepType(DataModel::SweepType::Rotational);
+    dataModel.spans = 16;
+    for (int p = 0; p < 8; p++)
+        dataModel.profileVertices.push_back(glm::vec3(1 + p % 2, p, 0));
+
+    // several meshlets to corrupt one of
+    sweeper.setMeshletVertices(256);
+
+    if (!sweeper.sweep(dataModel, mesh) ||
+        !ModelFile::save(validPath, dataModel, &mesh) ||
+        !readFile(validPath, valid))
+    {
+        fprintf(stderr, "cannot write %s\n", validPath);
+        return 1;
+    }
+
+    ModelFile file;
+    SweepMesh loaded;
+    check("valid file opens", file.open(validPath));
+    check("valid file has meshlets", file.meshletCount() > 1);
+    check("valid mesh loads", file.loadMesh(loaded) &&
+          loaded.vertices.size() == mesh.vertices.size());
+    file.close();
+
+    if (mesh.indices.meshlets.size() < 2)
+        return 1;
+
+    // restart indices are no vertices
+    SweepMesh strips;
+    sweeper.setTopology(IndexBuffer::Topology::TriangleStrip);
+    check("valid strips open", sweeper.sweep(dataModel, strips) &&
+          ModelFile::save(corruptPath, dataModel, &strips) &&
+          file.open(corruptPath));
+    file.close();
+
+    check("meshlet starting past the indices is rejected",
+          !opensCorrupted(valid, [](ModelFileHeader &h, ModelFileMeshlet *m)
+          {
+              m[1].firstIndex = h.indices;
+          }));
+    check("meshlet ending past the indices is rejected",
+          !opensCorrupted(valid, [](ModelFileHeader &h, ModelFileMeshlet *m)
+          {
+              m[1].indexCount = h.indices - m[1].firstIndex + 1;
+          }));
+    check("meshlet count wrapping around is rejected",
+          !opensCorrupted(valid, [](ModelFileHeader&, ModelFileMeshlet *m)
+          {
+              m[1].indexCount = UINT64_MAX;
+          }));
+    check("meshlet indexing past the vertices is rejected",
+          !opensCorrupted(valid, [](ModelFileHeader &h, ModelFileMeshlet *m)
+          {
+              m[1].baseVertex = h.vertices;
+          }));
+    check("indices without meshlets are rejected",
+          !opensCorrupted(valid, [](ModelFileHeader &h, ModelFileMeshlet*)
+          {
+              h.meshlets = 0;
+          }));
+    check("unknown topology is rejected",
+          !opensCorrupted(valid, [](ModelFileHeader &h, ModelFileMeshlet*)
+          {
+              h.topology = 2;
+          }));
+    check("truncated file is rejected",
+          !opensCorrupted(valid, [](ModelFileHeader &h, ModelFileMeshlet*)
+          {
+              h.meshlets += 1024;
+          }));
+
+    remove(validPath);
+    remove(corruptPath);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Converts DataModel text files into memory mapped ModelFiles
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "DataModel.hpp"
+#include "ModelFile.hpp"
+#include "Sweeper.hpp"
+
+void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-g] [-m <meshlet vertices>] [-s] [-o <output>]\n"
+            "          <model files..>\n",
+            name);
+}
+
+double msSince(const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output;
+    bool generate = false;
+    size_t meshletVertices = 0;
+    bool strips = false;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (strcmp(argv[i], "-g") == 0)
+        {
+            generate = true;
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            meshletVertices = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            strips = true;
+        }
+        else if (argv[i][0] == '-')
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    // a single output name for a single input
+    if (inputs.empty() || (!output.empty() && inputs.size() > 1))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ThreadPool pool;
+
+    Sweeper sweeper;
+    sweeper.setMeshletVertices(meshletVertices);
+    if (strips)
+        sweeper.setTopology(IndexBuffer::Topology::TriangleStrip);
+    sweeper.setThreadPool(&pool);
+
+    size_t failed = 0;
+    for (const auto &input: inputs)
+    {
+        DataModel dataModel;
+        SweepMesh mesh;
+        std::string filename = output.empty() ? input + ".bin" : output;
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (!dataModel.loadInputFile(input))
+        {
+            fprintf(stderr, "%s: cannot load\n", input.c_str());
+            failed++;
+            continue;
+        }
+        double parseMs = msSince(start);
+
+        if (generate && !sweeper.sweep(dataModel, mesh))
+        {
+            fprintf(stderr, "%s: cannot sweep\n", input.c_str());
+            failed++;
+            continue;
+        }
+
+        start = std::chrono::steady_clock::now();
+        if (!ModelFile::save(filename, dataModel, generate ? &mesh : NULL))
+        {
+            fprintf(stderr, "%s: cannot write\n", filename.c_str());
+            failed++;
+            continue;
+        }
+        double saveMs = msSince(start);
+
+        // the same model mapped back, nothing to parse
+        ModelFile file;
+        start = std::chrono::steady_clock::now();
+        if (!file.open(filename))
+        {
+            failed++;
+            continue;
+        }
+        double openMs = msSince(start);
+
+        printf("%s -> %s (%zu + %zu control points, %zu vertices, "
+               "%zu bytes; parsed in %.2f ms, written in %.2f ms, "
+               "mapped in %.3f ms)\n",
+               input.c_str(), filename.c_str(),
+               file.profilePoints(), file.trajectoryPoints(),
+               file.vertexCount(), file.bytes(),
+               parseMs, saveMs, openMs);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,313 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Headless sweeping of DataModel files into Wavefront OBJ meshes
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "DataModel.hpp"
+#include "ModelFile.hpp"
+#include "Sweeper.hpp"
+#include "Welder.hpp"
+
+struct BatchJob
+{
+    std::string input;
+    std::string output;
+    bool done = false;
+    size_t vertices = 0;
+    size_t triangles = 0;
+    size_t indices = 0;
+    size_t meshlets = 0;
+    IndexBuffer::Width indexWidth = IndexBuffer::Width::U16;
+    // curve samples emitted vs. a uniform tessellation
+    size_t samples = 0;
+    size_t uniformSamples = 0;
+    WeldStats weld;
+    double ms = 0;
+};
+
+void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-o <output dir>] [-j <threads>]\n"
+            "          [-c <chordal tolerance>] [-a <angular tolerance (deg)>]\n"
+            "          [-m <meshlet vertices>] [-s] [-w] [-e <weld epsilon>]\n"
+            "          <model files..>\n",
+            name);
+}
+
+std::string outputPath(const std::string &dir, const std::string &input)
+{
+    size_t slash = input.find_last_of('/');
+    std::string base = (slash == std::string::npos) ?
+        input : input.substr(slash + 1);
+    return dir + "/" + base + ".obj";
+}
+
+bool saveObj(const std::string &filename, const SweepMesh &mesh,
+             size_t &faces)
+{
+    std::string buffer;
+    char line[128];
+
+    buffer.reserve(mesh.vertices.size() * 40 + mesh.indices.size() * 8);
+
+    for (const auto &v: mesh.vertices)
+    {
+        int n = snprintf(line, sizeof(line), "v %g %g %g\n", v.x, v.y, v.z);
+        buffer.append(line, n);
+    }
+    std::vector<uint32_t> triangles;
+    mesh.indices.triangles(triangles);
+
+    for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        // obj indices are 1-based
+        int n = snprintf(line, sizeof(line), "f %u %u %u\n",
+                         triangles[i] + 1,
+                         triangles[i + 1] + 1,
+                         triangles[i + 2] + 1);
+        buffer.append(line, n);
+    }
+    faces = triangles.size() / 3;
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool written = fwrite(buffer.data(), 1, buffer.size(), file) ==
+                   buffer.size();
+    return (fclose(file) == 0) && written;
+}
+
+// sweeps a ModelFile straight out of its mapping, a text file once parsed
+bool sweepInput(const Sweeper &sweeper, const std::string &input,
+                DataModel::SweepType &sweepType, size_t &profilePoints,
+                size_t &trajectoryPoints, SweepMesh &mesh)
+{
+    if (ModelFile::isModelFile(input))
+    {
+        ModelFile file;
+
+        if (!file.open(input))
+            return false;
+
+        sweepType = file.getSweepType();
+        profilePoints = file.profilePoints();
+        trajectoryPoints = file.trajectoryPoints();
+        return sweeper.sweep(sweepType, file.getSpans(),
+                             file.profile(), file.profilePoints(),
+                             file.trajectory(), file.trajectoryPoints(),
+                             mesh);
+    }
+
+    DataModel dataModel;
+
+    if (!dataModel.loadInputFile(input))
+        return false;
+
+    sweepType = dataModel.getSweepType();
+    profilePoints = dataModel.profileVertices.size();
+    trajectoryPoints = dataModel.trajectoryVertices.size();
+    return sweeper.sweep(dataModel, mesh);
+}
+
+// welder: NULL to keep every vertex, sweepWeld for the exact sweep cases
+void runJob(const Sweeper &sweeper, const Welder *welder,
+            const bool sweepWeld, BatchJob &job)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    DataModel::SweepType sweepType;
+    size_t profilePoints = 0;
+    size_t trajectoryPoints = 0;
+    SweepMesh mesh;
+
+    if (!sweepInput(sweeper, job.input, sweepType, profilePoints,
+                    trajectoryPoints, mesh))
+        return;
+
+    if (welder && sweepWeld)
+        job.weld = welder->weldSweep(sweepType, mesh.profile.size(),
+                                     mesh.vertices, mesh.indices);
+    else if (welder)
+        job.weld = welder->weld(mesh.vertices, mesh.indices);
+
+    if (saveObj(job.output, mesh, job.triangles))
+    {
+        job.done = true;
+        job.vertices = mesh.vertices.size();
+        job.indices = mesh.indices.size();
+        job.meshlets = mesh.indices.meshlets.size();
+        job.indexWidth = mesh.indices.getWidth();
+
+        const CatmullRom &curve = sweeper.getCurve();
+        job.samples = mesh.profile.size() + mesh.trajectory.size();
+        job.uniformSamples = curve.uniformSamples(profilePoints) +
+                             curve.uniformSamples(trajectoryPoints);
+    }
+    job.ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string outputDir = ".";
+    unsigned int threads = 0;
+    float chordalTolerance = 0;
+    float angularTolerance = 0;
+    size_t meshletVertices = 0;
+    bool strips = false;
+    bool weld = false;
+    bool sweepWeld = false;
+    bool epsilonWeld = false;
+    float weldEpsilon = 0;
+    std::vector<BatchJob> jobs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            outputDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            chordalTolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+        {
+            angularTolerance = glm::radians(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            meshletVertices = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            strips = true;
+        }
+        else if (strcmp(argv[i], "-w") == 0)
+        {
+            weld = sweepWeld = true;
+        }
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            weld = epsilonWeld = true;
+            weldEpsilon = atof(argv[++i]);
+        }
+        else if (argv[i][0] == '-')
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            BatchJob job;
+            job.input = argv[i];
+            jobs.push_back(job);
+        }
+    }
+
+    if (jobs.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // an epsilon asked for wins over -w, whatever the order
+    if (epsilonWeld)
+        sweepWeld = false;
+
+    // a weld leaves a single triangle list, see Welder
+    if (weld && (strips || meshletVertices))
+    {
+        fprintf(stderr, "-w and -e leave a single triangle list, "
+                        "neither -s nor -m apply to them\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    mkdir(outputDir.c_str(), 0755);
+
+    for (auto &job: jobs)
+        job.output = outputPath(outputDir, job.input);
+
+    auto start = std::chrono::steady_clock::now();
+
+    CatmullRom curve;
+    if (chordalTolerance > 0 || angularTolerance > 0)
+        curve.setAdaptive(chordalTolerance, angularTolerance);
+
+    // one pool for both models and sweeps within them
+    ThreadPool pool(threads);
+
+    Sweeper sweeper(curve);
+    sweeper.setMeshletVertices(meshletVertices);
+    if (strips)
+        sweeper.setTopology(IndexBuffer::Topology::TriangleStrip);
+    sweeper.setThreadPool(&pool);
+
+    Welder welder(weldEpsilon);
+
+    pool.parallelFor(0, jobs.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t j = begin; j < end; j++)
+            runJob(sweeper, weld ? &welder : NULL, sweepWeld, jobs[j]);
+    });
+
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0;
+    size_t samples = 0;
+    size_t uniformSamples = 0;
+    size_t weldedVertices = 0;
+    size_t removedVertices = 0;
+    for (const auto &job: jobs)
+    {
+        if (job.done)
+        {
+            printf("%s -> %s (%zu vertices, %zu triangles, "
+                   "%zu u%i indices in %zu meshlet(s), "
+                   "%zu/%zu curve samples, %.2f ms)\n",
+                   job.input.c_str(), job.output.c_str(),
+                   job.vertices, job.triangles,
+                   job.indices, job.indexWidth * 8, job.meshlets,
+                   job.samples, job.uniformSamples, job.ms);
+            samples += job.samples;
+            uniformSamples += job.uniformSamples;
+            weldedVertices += job.weld.vertices;
+            removedVertices += job.weld.removedVertices;
+        }
+        else
+        {
+            fprintf(stderr, "%s: failed\n", job.input.c_str());
+            failed++;
+        }
+    }
+    printf("%zu model(s), %zu failed, %u thread(s), %.2f ms\n",
+           jobs.size(), failed, pool.size(), ms);
+    printf("%s tessellation: %zu curve samples (uniform: %zu)\n",
+           curve.getSubdivision() == CatmullRom::Subdivision::Adaptive ?
+                "adaptive" : "uniform",
+           samples, uniformSamples);
+    if (weld)
+        printf("weld: removed %zu of %zu vertices (%.1f%%)\n",
+               removedVertices, weldedVertices,
+               weldedVertices ? 100.0 * removedVertices / weldedVertices : 0);
+
+    return failed ? 1 : 0;
+}
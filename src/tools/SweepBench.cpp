@@ -0,0 +1,436 @@
+/*
+ * @file
+ * @author Vsevolod (Seva) Ivanov
+ * @brief Microbenchmarks of the geometry core over synthetic profiles
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+#include "CurveStream.hpp"
+#include "DataModel.hpp"
+#include "ModelFile.hpp"
+#include "Sweeper.hpp"
+
+enum Shape {
+    Circle = 0,
+    Noise = 1,
+    ZigZag = 2,
+    Shapes = 3
+};
+
+static const char* shapeNames[Shapes] = {"circle", "noise", "zigzag"};
+
+/*
+ * Deterministic profiles in the y = 0 plane, x > 0 so that the
+ * rotational sweep never crosses its axis.
+*/
+void genProfile(const Shape shape, const size_t points,
+                std::vector<glm::vec3> &profile)
+{
+    // numerical recipes lcg, same sequence on every run
+    uint32_t seed = 12345;
+
+    profile.resize(points);
+
+    for (size_t i = 0; i < points; i++)
+    {
+        float t = (float) i / (points > 1 ? points - 1 : 1);
+
+        switch (shape)
+        {
+            case Shape::Circle:
+            {
+                float a = 2 * M_PI * t;
+                profile[i] = glm::vec3(1.0f + 0.5f * cosf(a), 0,
+                                       0.5f * sinf(a));
+                break;
+            }
+            case Shape::Noise:
+            {
+                seed = seed * 1664525u + 1013904223u;
+                float r = (seed >> 8) / 16777216.0f;
+                profile[i] = glm::vec3(0.1f + r, 0, 2 * t - 1);
+                break;
+            }
+            default:
+                // like data/rotational_bowl
+                profile[i] = glm::vec3((i % 2) ? 0.37f : 0.92f, 0,
+                                       2 * t - 1);
+                break;
+        }
+    }
+}
+
+// in the z = 0 plane, one step per sweep
+void genTrajectory(const size_t points, std::vector<glm::vec3> &trajectory)
+{
+    trajectory.resize(points);
+
+    for (size_t i = 0; i < points; i++)
+        trajectory[i] = glm::vec3(0.1f * i, 0.05f * sinf(0.3f * i), 0);
+}
+
+struct Result
+{
+    std::string benchmark;
+    const char *shape;
+    const char *type;
+    size_t points;
+    size_t spans;
+    // vertices produced (or indexed, or stored) by one run
+    size_t vertices;
+    double msMin;
+    double msAvg;
+    size_t bytesAllocated;
+    size_t allocations;
+};
+
+/*
+ * Runs the task repetitions times, the first one is also measured
+ * for its allocations.
+*/
+template <typename Task>
+Result measure(const unsigned int repetitions, Task task)
+{
+    Result result = Result();
+    double total = 0;
+
+    result.msMin = HUGE_VAL;
+
+    for (unsigned int r = 0; r < repetitions; r++)
+    {
+        size_t bytes = AllocationCounter::bytes();
+        size_t count = AllocationCounter::allocations();
+        auto start = std::chrono::steady_clock::now();
+
+        result.vertices = task();
+
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        if (r == 0)
+        {
+            result.bytesAllocated = AllocationCounter::bytes() - bytes;
+            result.allocations = AllocationCounter::allocations() - count;
+        }
+        result.msMin = std::min(result.msMin, ms);
+        total += ms;
+    }
+    result.msAvg = total / repetitions;
+    return result;
+}
+
+void printCsvHeader(FILE *out)
+{
+    fprintf(out, "benchmark,shape,type,points,spans,vertices,"
+                 "ms_min,ms_avg,vertices_per_s,bytes_allocated,"
+                 "allocations\n");
+}
+
+void printResult(FILE *out, const bool json, const bool first,
+                 const Result &r)
+{
+    double perSecond = r.msMin > 0 ? r.vertices / (r.msMin / 1e3) : 0;
+
+    if (!json)
+    {
+        fprintf(out, "%s,%s,%s,%zu,%zu,%zu,%.4f,%.4f,%.0f,%zu,%zu\n",
+                r.benchmark.c_str(), r.shape, r.type, r.points, r.spans,
+                r.vertices, r.msMin, r.msAvg, perSecond,
+                r.bytesAllocated, r.allocations);
+        return;
+    }
+    fprintf(out, "%s  {\"benchmark\": \"%s\", \"shape\": \"%s\", "
+                 "\"type\": \"%s\", \"points\": %zu, \"spans\": %zu, "
+                 "\"vertices\": %zu, \"ms_min\": %.4f, \"ms_avg\": %.4f, "
+                 "\"vertices_per_s\": %.0f, \"bytes_allocated\": %zu, "
+                 "\"allocations\": %zu}",
+            first ? "" : ",\n", r.benchmark.c_str(), r.shape, r.type,
+            r.points, r.spans, r.vertices, r.msMin, r.msAvg, perSecond,
+            r.bytesAllocated, r.allocations);
+}
+
+void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-p <max control points>] [-s <spans,..>]\n"
+            "          [-r <repetitions>] [-b <max swept vertices>]\n"
+            "          [-j <threads>] [-f csv|json] [-o <output>]\n",
+            name);
+}
+
+std::vector<size_t> parseList(const char *list)
+{
+    std::vector<size_t> values;
+
+    for (const char *p = list; *p; )
+    {
+        char *end;
+        size_t value = strtoul(p, &end, 10);
+        if (end == p)
+            break;
+        values.push_back(value);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxPoints = 1000000;
+    std::vector<size_t> spansList = {16, 256};
+    unsigned int repetitions = 5;
+    // swept vertices a single run may produce, ~240 MB of vec3
+    size_t maxVertices = 20000000;
+    unsigned int threads = 1;
+    bool json = false;
+    const char *output = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            maxPoints = atol(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            spansList = parseList(argv[++i]);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repetitions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            maxVertices = atol(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            json = strcmp(argv[++i], "json") == 0;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (repetitions == 0 || spansList.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out)
+    {
+        perror(output);
+        return 1;
+    }
+
+    // 1 thread: the calling one, no pool
+    ThreadPool pool(threads);
+
+    Sweeper sweeper;
+    if (threads != 1)
+        sweeper.setThreadPool(&pool);
+    const CatmullRom &curve = sweeper.getCurve();
+
+    char scratch[64];
+    snprintf(scratch, sizeof(scratch), "/tmp/sweep-bench-%d", getpid());
+    std::string textFile = std::string(scratch) + ".txt";
+    std::string modelFile = std::string(scratch) + ".bin";
+
+    bool first = true;
+    auto emit = [&](Result result, const char *benchmark, const Shape shape,
+                    const char *type, const size_t points,
+                    const size_t spans)
+    {
+        result.benchmark = benchmark;
+        result.shape = shapeNames[shape];
+        result.type = type;
+        result.points = points;
+        result.spans = spans;
+        printResult(out, json, first, result);
+        first = false;
+        fflush(out);
+    };
+
+    if (json)
+        fprintf(out, "[\n");
+    else
+        printCsvHeader(out);
+
+    for (size_t points = 10; points <= maxPoints; points *= 10)
+    {
+        for (int s = 0; s < Shape::Shapes; s++)
+        {
+            Shape shape = (Shape) s;
+            std::vector<glm::vec3> profile, samples, vertices;
+            std::vector<glm::vec3> tangents, normals;
+
+            genProfile(shape, points, profile);
+
+            emit(measure(repetitions, [&]()
+            {
+                curve.evaluate(profile, samples);
+                return samples.size();
+            }), "evaluate", shape, "-", points, 0);
+
+            // the derivatives as well, in the same pass
+            emit(measure(repetitions, [&]()
+            {
+                curve.evaluate(&profile[0], profile.size(), samples,
+                               tangents);
+                return samples.size();
+            }), "evaluate_tangents", shape, "-", points, 0);
+
+            // into a ring of 64k samples, constant cost per point
+            CurveStream stream(curve, 65536);
+            emit(measure(repetitions, [&]()
+            {
+                stream.clear();
+                for (const auto &p: profile)
+                    stream.append(p);
+                return (size_t) stream.written();
+            }), "stream_append", shape, "-", points, 0);
+
+            for (size_t spans: spansList)
+            {
+                if (samples.size() * (spans + 1) > maxVertices)
+                    continue;
+
+                // allocations measured from scratch
+                std::vector<glm::vec3>().swap(vertices);
+                emit(measure(repetitions, [&]()
+                {
+                    sweeper.sweepRotational(samples, spans, vertices);
+                    return vertices.size();
+                }), "sweep", shape, "rotational", points, spans);
+
+                std::vector<glm::vec3>().swap(vertices);
+                std::vector<glm::vec3>().swap(normals);
+                emit(measure(repetitions, [&]()
+                {
+                    sweeper.sweepRotational(samples, tangents, spans,
+                                            vertices, normals);
+                    return vertices.size();
+                }), "sweep_normals", shape, "rotational", points, spans);
+
+                std::vector<glm::vec3> trajectory;
+                genTrajectory(spans, trajectory);
+
+                std::vector<glm::vec3>().swap(vertices);
+                emit(measure(repetitions, [&]()
+                {
+                    sweeper.sweepTranslational(samples, trajectory,
+                                               vertices);
+                    return vertices.size();
+                }), "sweep", shape, "translational", points, spans);
+
+                for (int t = 0; t < 2; t++)
+                {
+                    IndexBuffer indices;
+                    Sweeper indexer(sweeper);
+                    indexer.setTopology((IndexBuffer::Topology) t);
+
+                    emit(measure(repetitions, [&]()
+                    {
+                        indexer.genIndices(samples.size(), spans, indices);
+                        return samples.size() * (spans + 1);
+                    }), t ? "indices_strips" : "indices", shape, "-",
+                         points, spans);
+                }
+            }
+
+            // one control point moved, only what it reaches re-swept
+            size_t editSpans = spansList[0];
+            if (samples.size() * (editSpans + 1) <= maxVertices)
+            {
+                std::vector<glm::vec3> edited(profile), editedSamples(samples);
+                std::vector<glm::vec3> noTrajectory;
+
+                sweeper.sweepRotational(editedSamples, editSpans, vertices);
+                emit(measure(repetitions, [&]()
+                {
+                    size_t i = edited.size() / 2;
+                    SampleRange changed = sweeper.moveControlPoint(
+                        edited, editedSamples, i, edited[i] * 1.01f);
+                    sweeper.resweepProfile(
+                        DataModel::SweepType::Rotational, editedSamples,
+                        noTrajectory, editSpans, changed, vertices);
+                    return (changed.end - changed.begin) * (editSpans + 1);
+                }), "edit_move", shape, "rotational", points, editSpans);
+            }
+
+            // a whole regeneration, its scratch memory from an arena:
+            // nothing allocated once warmed up
+            if (samples.size() * (editSpans + 1) <= maxVertices)
+            {
+                Arena arena;
+                Sweeper regenerator(sweeper);
+                regenerator.setArena(&arena);
+                SweepMesh mesh;
+
+                auto regenerate = [&]()
+                {
+                    arena.reset();
+                    regenerator.sweep(DataModel::SweepType::Rotational,
+                                      editSpans, &profile[0], profile.size(),
+                                      NULL, 0, mesh);
+                    return mesh.vertices.size();
+                };
+                // the warm up's scratch merged into a single block
+                regenerate();
+                arena.reset();
+                emit(measure(repetitions, regenerate), "regenerate", shape,
+                     "rotational", points, editSpans);
+            }
+
+            // files: a rotational model of these control points
+            DataModel dataModel;
+            dataModel.verbose = false;
+            dataModel.setSweepType(DataModel::SweepType::Rotational);
+            dataModel.spans = spansList[0];
+            dataModel.profileVertices = profile;
+
+            emit(measure(repetitions, [&]()
+            {
+                dataModel.saveFile(textFile);
+                return profile.size();
+            }), "save_text", shape, "rotational", points, 0);
+
+            emit(measure(repetitions, [&]()
+            {
+                DataModel loaded;
+                loaded.loadInputFile(textFile);
+                return loaded.profileVertices.size();
+            }), "load_text", shape, "rotational", points, 0);
+
+            ModelFile::save(modelFile, dataModel);
+
+            emit(measure(repetitions, [&]()
+            {
+                ModelFile file;
+                file.open(modelFile);
+                // touch every point, as a sweep would
+                float sum = 0;
+                for (size_t i = 0; i < file.profilePoints(); i++)
+                    sum += file.profile()[i].x;
+                return sum > 0 ? file.profilePoints() : 0;
+            }), "map_model", shape, "rotational", points, 0);
+        }
+    }
+
+    if (json)
+        fprintf(out, "\n]\n");
+
+    unlink(textFile.c_str());
+    unlink(modelFile.c_str());
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}